@@ -0,0 +1,146 @@
+#include "Chunk.h"
+#include "PartitionedDeduplicator.h"
+#include "StringUtilities.h"
+#include "UniqueWords.h"
+#include "WordSet.h"
+#include "WorkStealingScheduler.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// compares the partitioned deduplication with a set shared by all the threads, split into stripes that each have
+// a lock, on the tokenized chunks of a text with a large vocabulary
+// the shared set does not keep the order of first occurrence, it only gives the cost of the contention
+namespace
+{
+    constexpr size_t WORD_COUNT       = 1 << 22;
+    constexpr size_t CHUNK_WORD_COUNT = 1 << 16;
+    constexpr size_t VOCABULARY_SIZE  = 1'000'000;
+    constexpr size_t STRIPE_COUNT     = 64;
+
+    // words of 1 to 14 lowercase letters, drawn from the vocabulary with a Zipf-like distribution
+    vector<string> makeText()
+    {
+        mt19937 generator(42);
+        uniform_int_distribution<int> letterDistribution('a', 'z');
+        uniform_int_distribution<int> lengthDistribution(1, 14);
+        vector<string> vocabulary(VOCABULARY_SIZE);
+        for (string& word : vocabulary) {
+            for (int length = lengthDistribution(generator); length > 0; --length) {
+                word += static_cast<char>(letterDistribution(generator));
+            }
+        }
+        vector<double> weights(VOCABULARY_SIZE);
+        for (size_t rank = 0; rank < VOCABULARY_SIZE; ++rank) {
+            weights[rank] = 1.0 / static_cast<double>(rank + 1);
+        }
+        discrete_distribution<size_t> wordDistribution(weights.begin(), weights.end());
+        vector<string> text(WORD_COUNT);
+        for (string& word : text) {
+            word = vocabulary[wordDistribution(generator)];
+        }
+        return text;
+    }
+
+    // the chunks as the tokenizer leaves them, with one scheme scoring the length of the words
+    vector<Chunk> makeChunks(const vector<string>& text)
+    {
+        vector<Chunk> chunks((text.size() + CHUNK_WORD_COUNT - 1) / CHUNK_WORD_COUNT);
+        for (size_t i = 0; i < text.size(); ++i) {
+            Chunk& chunk = chunks[i / CHUNK_WORD_COUNT];
+            chunk.words.push_back(text[i]);
+            chunk.hashes.push_back(string_utilities::hashWord(text[i]));
+            chunk.points.push_back(static_cast<int>(text[i].size()));
+        }
+        return chunks;
+    }
+
+    struct Stripe
+    {
+        mutex lock;
+        WordSet words;
+    };
+
+    size_t deduplicateShared(const vector<Chunk>& chunks, unsigned threadCount)
+    {
+        array<Stripe, STRIPE_COUNT> stripes;
+        atomic<size_t> nextChunk = 0;
+        {
+            vector<jthread> threads;
+            for (unsigned thread = 0; thread < threadCount; ++thread) {
+                threads.emplace_back([&chunks, &stripes, &nextChunk]() {
+                    for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+                        const Chunk& chunk = chunks[i];
+                        for (size_t word = 0; word < chunk.words.size(); ++word) {
+                            // the bits under the tag, as for the partitions, the low bits select the group
+                            Stripe& stripe = stripes[(chunk.hashes[word] >> 51) % STRIPE_COUNT];
+                            const lock_guard<mutex> guard(stripe.lock);
+                            stripe.words.insert(chunk.words[word], chunk.hashes[word]);
+                        }
+                    }
+                });
+            }
+        }
+        size_t uniqueCount = 0;
+        for (const Stripe& stripe : stripes) {
+            uniqueCount += stripe.words.size();
+        }
+        return uniqueCount;
+    }
+
+    size_t deduplicatePartitioned(vector<Chunk>& chunks, WorkStealingScheduler& scheduler)
+    {
+        PartitionedDeduplicator deduplicator(1);
+        {
+            TaskGroup splitTasks(scheduler);
+            for (Chunk& chunk : chunks) {
+                splitTasks.run([&deduplicator, &chunk]() { deduplicator.split(chunk, chunk.partitionSlices); });
+            }
+            splitTasks.wait();
+        }
+        for (Chunk& chunk : chunks) {
+            deduplicator.append(std::move(chunk.partitionSlices));
+        }
+        UniqueWords uniqueWords;
+        uniqueWords.pointsPerScheme.resize(1);
+        deduplicator.finish(scheduler, uniqueWords);
+        return uniqueWords.words.size();
+    }
+
+    template <typename Deduplicate>
+    void measure(const string& name, Deduplicate deduplicate)
+    {
+        const auto start                             = chrono::steady_clock::now();
+        const size_t uniqueCount                     = deduplicate();
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        cout << name << ": " << elapsed.count() / static_cast<double>(WORD_COUNT) << " ns per word, " << uniqueCount
+             << " unique words" << endl;
+    }
+} // namespace
+
+int main()
+{
+    const vector<string> text = makeText();
+    vector<Chunk> chunks      = makeChunks(text);
+    for (const unsigned threadCount : { 8U, 32U, 64U }) {
+        cout << threadCount << " threads" << endl;
+        measure("shared set with " + to_string(STRIPE_COUNT) + " locked stripes", [&chunks, threadCount]() {
+            return deduplicateShared(chunks, threadCount);
+        });
+        WorkStealingScheduler scheduler(threadCount);
+        measure("partitioned", [&chunks, &scheduler]() { return deduplicatePartitioned(chunks, scheduler); });
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+
+#include "AlphabetScorer.h"
+#include "ScoringScheme.h"
+#include "WordBatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <span>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// compares the scorer compiled from defaultAlphabet with the runtime table built from the same letters,
+// scoring one word per call and a batch of words per call
+// a character missing from the scheme is an ordinary lookup, the corpus full of digits and punctuation
+// must score as fast as prose
+namespace
+{
+    constexpr size_t WORD_COUNT = 1 << 20;
+    constexpr int ROUND_COUNT   = 20;
+    constexpr size_t BATCH_SIZE = 1024;
+
+    // words drawn from the scored letters, with a share of digits and punctuation that count as 0
+    // about one letter in twenty is not ASCII, as in French prose
+    vector<string> makeWords(double symbolShare)
+    {
+        vector<string> asciiLetters;
+        vector<string> otherLetters = { "\xE2\x82\xAC" };
+        for (const LetterPoints& letter : defaultAlphabet) {
+            const char32_t codepoint = letter.codepoint;
+            if (codepoint < 0x80) {
+                asciiLetters.emplace_back(1, static_cast<char>(codepoint));
+            } else {
+                otherLetters.push_back(
+                    { static_cast<char>(0xC0 | (codepoint >> 6)), static_cast<char>(0x80 | (codepoint & 0x3F)) });
+            }
+        }
+        const vector<string> symbols = { "0", "3", "7", "9", "-", ".", ";", "(", ")", "%", "\xC2\xAB" };
+        mt19937 generator(42);
+        bernoulli_distribution isSymbol(symbolShare);
+        bernoulli_distribution otherShare(0.05);
+        uniform_int_distribution<size_t> asciiLetterDistribution(0, asciiLetters.size() - 1);
+        uniform_int_distribution<size_t> otherLetterDistribution(0, otherLetters.size() - 1);
+        uniform_int_distribution<size_t> symbolDistribution(0, symbols.size() - 1);
+        uniform_int_distribution<int> lengthDistribution(1, 14);
+        vector<string> words(WORD_COUNT);
+        for (string& word : words) {
+            for (int length = lengthDistribution(generator); length > 0; --length) {
+                if (isSymbol(generator)) {
+                    word += symbols[symbolDistribution(generator)];
+                    continue;
+                }
+                word += otherShare(generator) ? otherLetters[otherLetterDistribution(generator)]
+                                              : asciiLetters[asciiLetterDistribution(generator)];
+            }
+        }
+        return words;
+    }
+
+    template <typename Scorer>
+    void measure(const string& name, const vector<string>& words, Scorer scorer)
+    {
+        long long checksum = 0;
+        const auto start   = chrono::steady_clock::now();
+        for (int round = 0; round < ROUND_COUNT; ++round) {
+            for (const string& word : words) {
+                checksum += scorer(word);
+            }
+        }
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        cout << name << ": " << elapsed.count() / (static_cast<double>(words.size()) * ROUND_COUNT)
+             << " ns per word, checksum " << checksum << endl;
+    }
+
+    // the words are packed in one buffer, as the pipeline hands them
+    template <typename Scorer>
+    void measureBatches(const string& name, const vector<string>& words, const Scorer& scorer)
+    {
+        string buffer;
+        vector<uint32_t> offsets;
+        vector<uint32_t> lengths;
+        for (const string& word : words) {
+            offsets.push_back(static_cast<uint32_t>(buffer.size()));
+            lengths.push_back(static_cast<uint32_t>(word.size()));
+            buffer += word;
+        }
+        vector<int> points(BATCH_SIZE);
+        long long checksum = 0;
+        const auto start   = chrono::steady_clock::now();
+        for (int round = 0; round < ROUND_COUNT; ++round) {
+            for (size_t first = 0; first < words.size(); first += BATCH_SIZE) {
+                const size_t count = min(BATCH_SIZE, words.size() - first);
+                const WordBatch batch { buffer.data(),
+                    span(offsets).subspan(first, count),
+                    span(lengths).subspan(first, count) };
+                word_batch::countPoints(scorer, batch, points);
+                for (size_t i = 0; i < count; ++i) {
+                    checksum += points[i];
+                }
+            }
+        }
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        cout << name << ": " << elapsed.count() / (static_cast<double>(words.size()) * ROUND_COUNT)
+             << " ns per word, checksum " << checksum << endl;
+    }
+} // namespace
+
+int main()
+{
+    const shared_ptr<const ScoringScheme> defaultScheme = ScoringScheme::defaultScheme();
+    for (const auto& [corpus, symbolShare] : { pair("prose", 0.05), pair("digits and punctuation", 0.6) }) {
+        cout << corpus << endl;
+        const vector<string> words = makeWords(symbolShare);
+        measure("compile-time DefaultScorer", words, [](string_view word) {
+            return DefaultScorer::countPoints(word);
+        });
+        measure("runtime ScoringScheme", words, [&defaultScheme](string_view word) {
+            return defaultScheme->countPoints(word);
+        });
+        measureBatches("compile-time DefaultScorer, batches", words, DefaultScorer());
+        measureBatches("runtime ScoringScheme, batches", words, *defaultScheme);
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "StringUtilities.h"
+#include "WordSet.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// compares WordSet with std::unordered_set on the deduplication of a text: most words are repeated,
+// a few frequent words make most of the text, as in prose
+// the last text draws its words uniformly from a large vocabulary: the table is far bigger than the cache,
+// the batches hide part of the misses, and the huge pages, when the kernel gives them, those of the TLB
+namespace
+{
+    constexpr size_t WORD_COUNT = 1 << 22;
+    constexpr int ROUND_COUNT   = 5;
+
+    // words of 1 to 14 lowercase letters
+    vector<string> makeVocabulary(size_t vocabularySize)
+    {
+        mt19937 generator(7);
+        uniform_int_distribution<int> letterDistribution('a', 'z');
+        uniform_int_distribution<int> lengthDistribution(1, 14);
+        vector<string> vocabulary(vocabularySize);
+        for (string& word : vocabulary) {
+            for (int length = lengthDistribution(generator); length > 0; --length) {
+                word += static_cast<char>(letterDistribution(generator));
+            }
+        }
+        return vocabulary;
+    }
+
+    // words drawn from the vocabulary with a Zipf-like distribution, or uniformly
+    vector<string_view> makeText(const vector<string>& vocabulary, bool isUniform)
+    {
+        mt19937 generator(42);
+        vector<double> weights(vocabulary.size());
+        for (size_t rank = 0; rank < vocabulary.size(); ++rank) {
+            weights[rank] = isUniform ? 1.0 : 1.0 / static_cast<double>(rank + 1);
+        }
+        discrete_distribution<size_t> wordDistribution(weights.begin(), weights.end());
+        vector<string_view> text(WORD_COUNT);
+        for (string_view& word : text) {
+            word = vocabulary[wordDistribution(generator)];
+        }
+        return text;
+    }
+
+    // the words are deduplicated as the pipeline does: the set is checked, then the new words are added
+    // the hashes come with the words, as the tokenizer computes them
+    template <typename Deduplicate>
+    void measure(const string& name, const vector<string_view>& text, Deduplicate deduplicate)
+    {
+        vector<uint64_t> hashes(text.size());
+        for (size_t i = 0; i < text.size(); ++i) {
+            hashes[i] = string_utilities::hashWord(text[i]);
+        }
+        size_t uniqueCount = 0;
+        const auto start   = chrono::steady_clock::now();
+        for (int round = 0; round < ROUND_COUNT; ++round) {
+            uniqueCount = deduplicate(text, hashes);
+        }
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        cout << name << ": " << elapsed.count() / (static_cast<double>(text.size()) * ROUND_COUNT)
+             << " ns per word, " << uniqueCount << " unique words" << endl;
+    }
+} // namespace
+
+int main()
+{
+    for (const auto& [vocabularySize, isUniform] :
+        { pair(size_t { 10'000 }, false), pair(size_t { 1'000'000 }, false), pair(size_t { 10'000'000 }, true) }) {
+        cout << "vocabulary of " << vocabularySize << " words" << (isUniform ? ", uniform" : "") << endl;
+        const vector<string> vocabulary = makeVocabulary(vocabularySize);
+        const vector<string_view> text  = makeText(vocabulary, isUniform);
+        measure("std::unordered_set", text, [](const vector<string_view>& words, const vector<uint64_t>&) {
+            unordered_set<string_view> set;
+            for (const string_view word : words) {
+                if (!set.contains(word)) {
+                    set.insert(word);
+                }
+            }
+            return set.size();
+        });
+        measure("WordSet", text, [](const vector<string_view>& words, const vector<uint64_t>& hashes) {
+            WordSet set;
+            for (size_t i = 0; i < words.size(); ++i) {
+                set.insert(words[i], hashes[i]);
+            }
+            return set.size();
+        });
+        measure("WordSet, batches", text, [](const vector<string_view>& words, const vector<uint64_t>& hashes) {
+            WordSet set;
+            set.insertBatch(words, hashes, [](size_t, string_view&) {});
+            return set.size();
+        });
+        measure("WordSet, batches, huge pages",
+            text,
+            [](const vector<string_view>& words, const vector<uint64_t>& hashes) {
+                WordSet set(true);
+                set.insertBatch(words, hashes, [](size_t, string_view&) {});
+                return set.size();
+            });
+    }
+    return 0;
+}
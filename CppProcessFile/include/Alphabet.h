@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+
+// a letter of an alphabet and its points
+struct LetterPoints
+{
+    char32_t codepoint;
+    int points;
+};
+
+// the French letters the tool has always scored, every other character counts as 0
+inline constexpr std::array<LetterPoints, 65> defaultAlphabet = { { { U'A', 32 },
+    { U'B', 36 },
+    { U'C', 33 },
+    { U'D', 40 },
+    { U'E', 41 },
+    { U'F', 47 },
+    { U'G', 31 },
+    { U'H', 27 },
+    { U'I', 49 },
+    { U'J', 28 },
+    { U'K', 30 },
+    { U'L', 42 },
+    { U'M', 29 },
+    { U'N', 38 },
+    { U'O', 51 },
+    { U'P', 43 },
+    { U'Q', 45 },
+    { U'R', 39 },
+    { U'S', 35 },
+    { U'T', 52 },
+    { U'U', 37 },
+    { U'V', 46 },
+    { U'W', 34 },
+    { U'X', 48 },
+    { U'Y', 44 },
+    { U'Z', 50 },
+    { U'\u00E9', 60 },
+    { U'\u00E8', 61 },
+    { U'\u00EA', 62 },
+    { U'\u00E0', 63 },
+    { U'\u00E2', 64 },
+    { U'\u00EB', 65 },
+    { U'\u00FB', 66 },
+    { U'\u00F9', 67 },
+    { U'\u00EE', 68 },
+    { U'\u00E7', 69 },
+    { U'\u00F4', 70 },
+    { U'\u00F6', 71 },
+    { U'\u00FC', 72 },
+    { U'a', 1 },
+    { U'b', 4 },
+    { U'c', 5 },
+    { U'd', 8 },
+    { U'e', 10 },
+    { U'f', 11 },
+    { U'g', 13 },
+    { U'h', 16 },
+    { U'i', 18 },
+    { U'j', 19 },
+    { U'k', 21 },
+    { U'l', 21 },
+    { U'm', 23 },
+    { U'n', 2 },
+    { U'o', 3 },
+    { U'p', 6 },
+    { U'q', 7 },
+    { U'r', 9 },
+    { U's', 12 },
+    { U't', 14 },
+    { U'u', 15 },
+    { U'v', 17 },
+    { U'w', 20 },
+    { U'x', 24 },
+    { U'y', 25 },
+    { U'z', 26 } } };
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Alphabet.h"
+#include "StringUtilities.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// a scoring scheme fixed at build time: the alphabet descriptor is compiled into a flat table covering the code
+// points up to the highest letter, plus one 0 shared by all the code points above it
+// a lookup is then one clamp and one load, without any dispatch, and the table is sized for the alphabet
+// the alphabets are expected to be compact, a letter far in the code space makes the table as large
+template <const auto& alphabet>
+class AlphabetScorer
+{
+public:
+    static constexpr int points(char32_t codepoint)
+    {
+        return table[std::min(codepoint, OUTSIDE_ALPHABET)];
+    }
+
+    // the word must be valid UTF-8
+    static int countPoints(std::string_view word)
+    {
+        int total = 0;
+        for (std::size_t position = 0; position < word.size();) {
+            total += points(string_utilities::decodeUtf8(word, position));
+        }
+        return total;
+    }
+
+private:
+    static constexpr char32_t OUTSIDE_ALPHABET = std::ranges::max(alphabet, {}, &LetterPoints::codepoint).codepoint + 1;
+
+    static constexpr std::array<int, OUTSIDE_ALPHABET + 1> table = []() {
+        std::array<int, OUTSIDE_ALPHABET + 1> points {};
+        for (const LetterPoints& letter : alphabet) {
+            points[letter.codepoint] = letter.points;
+        }
+        return points;
+    }();
+};
+
+// the built-in scheme, used when no scheme file is given
+using DefaultScorer = AlphabetScorer<defaultAlphabet>;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ByteSource.h"
+#include "WorkStealingScheduler.h"
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// runs blocking calls, such as reads, on threads of its own, so that the workers of the scheduler
+// never wait on a device
+class BlockingCallPool
+{
+public:
+    explicit BlockingCallPool(unsigned threadCount);
+    BlockingCallPool(const BlockingCallPool&)            = delete;
+    BlockingCallPool& operator=(const BlockingCallPool&) = delete;
+    ~BlockingCallPool();
+
+    void post(std::function<void()> call);
+
+private:
+    void runThread();
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::deque<std::function<void()>> calls;
+    bool stopping = false;
+    std::vector<std::jthread> threads;
+};
+
+// suspends the awaiting coroutine while the read runs on the pool, then resumes it as a task of the scheduler
+// a read the source can serve at once, such as a mapped file, completes without suspending
+class ReadAwaitable
+{
+public:
+    ReadAwaitable(ByteSource& source, std::span<char> destination, BlockingCallPool& pool,
+        WorkStealingScheduler& scheduler);
+
+    bool await_ready() const;
+    void await_suspend(std::coroutine_handle<> awaiting);
+    Expected<std::size_t> await_resume();
+
+private:
+    ByteSource& source;
+    std::span<char> destination;
+    BlockingCallPool& pool;
+    WorkStealingScheduler& scheduler;
+    bool suspended                  = false;
+    Expected<std::size_t> readCount = std::size_t { 0 };
+};
+
+// resumes the awaiting coroutine as a task of the scheduler, which lets the other queued tasks run first
+class YieldAwaitable
+{
+public:
+    explicit YieldAwaitable(WorkStealingScheduler& scheduler);
+
+    bool await_ready() const noexcept;
+    void await_suspend(std::coroutine_handle<> awaiting) const;
+    void await_resume() const noexcept;
+
+private:
+    WorkStealingScheduler& scheduler;
+};
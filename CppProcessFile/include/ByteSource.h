@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Expected.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+enum class IoBackend
+{
+    Stream,
+    Pread,
+    Mmap,
+    Uring
+};
+
+// a sequential source of input bytes, read by the reader stage of the pipeline
+class ByteSource
+{
+public:
+    virtual ~ByteSource() = default;
+    // copies at most capacity bytes to destination, returns 0 at the end of the input
+    virtual Expected<std::size_t> read(char* destination, std::size_t capacity) = 0;
+    // true when read returns without waiting for the device, an awaited read then does not suspend
+    virtual bool isReadReady() const
+    {
+        return false;
+    }
+};
+
+// a backend not available on the platform falls back to the closest one: uring to pread, pread and mmap to stream
+Expected<std::unique_ptr<ByteSource>> openByteSource(const std::string& path, IoBackend backend);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <span>
+
+enum class CaseFolding
+{
+    Off,
+    // the words are deduplicated, scored and written in lowercase
+    Lower,
+    // the words are deduplicated in lowercase, and written with the spelling and the points of their first occurrence
+    KeepSpelling
+};
+
+namespace case_folding
+{
+    // turns the uppercase letters of ASCII, Latin-1 and Latin Extended-A into lowercase, in place
+    // each letter keeps the length of its UTF-8 sequence, so the words keep their place in the buffer
+    // the letters without a lowercase of the same length, such as U+0130, are left as they are
+    void toLowercase(std::span<char> bytes);
+} // namespace case_folding
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ChunkMemory.h"
+#include "HugePages.h"
+#include "HyperLogLog.h"
+#include "InvalidInput.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct WordPosition
+{
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+// the words of a chunk that fall into one partition of the partitioned deduplication,
+// each at its first occurrence in the chunk
+// the slices outlive the chunk, they take their memory from the upstream resource of the chunk memory
+struct PartitionSlice
+{
+    struct Word
+    {
+        // the place of the word among the words of the chunk
+        std::uint32_t index;
+        std::uint32_t length;
+        // 0 when the word is its own key
+        std::uint32_t keyLength;
+        std::uint64_t hash;
+    };
+
+    // the words one after the other, each followed by its key when it has one
+    std::pmr::string bytes;
+    std::pmr::vector<Word> words;
+    // the points of each word under each scheme, points[word * schemeCount + scheme]
+    std::pmr::vector<int> points;
+};
+
+// a block of the input cut after a whitespace, so that no word spans two chunks
+struct Chunk
+{
+    Chunk() = default;
+
+    // the buffer of a big chunk is allocated on huge pages, the containers take their memory from upstream
+    explicit Chunk(bool usesHugePages, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) :
+        buffer(HugePageAllocator<char>(usesHugePages)), memory(std::make_unique<ChunkMemory>(upstream))
+    {
+    }
+
+    // empties the containers and releases their memory at once, the buffer and the sketch are kept
+    void releaseMemory()
+    {
+        previousWordCount = words.size();
+        chunk_memory::freeContainer(words);
+        chunk_memory::freeContainer(hashes);
+        chunk_memory::freeContainer(points);
+        chunk_memory::freeContainer(wordPositions);
+        chunk_memory::freeContainer(lineEnds);
+        chunk_memory::freeContainer(invalidInputs);
+        chunk_memory::freeContainer(repairs);
+        chunk_memory::freeContainer(normalizedWords);
+        chunk_memory::freeContainer(keys);
+        chunk_memory::freeContainer(lowercaseWords);
+        memory->release();
+    }
+
+    // position of the chunk in the input, the words are deduplicated in this order
+    std::size_t sequence = 0;
+    // byte offset of the first byte of the chunk in the input
+    std::uint64_t inputOffset = 0;
+    // the buffer is kept between uses, only the first size bytes are valid
+    HugePageVector<char> buffer;
+    std::size_t size = 0;
+    // the containers below, but the partition slices, take their memory from it
+    std::unique_ptr<ChunkMemory> memory = std::make_unique<ChunkMemory>(std::pmr::get_default_resource());
+    // a vector that grows in the monotonic memory leaves its old storage behind until the release, so the tokenizer
+    // reserves for a little more words than the previous use of the chunk had, chunks of one input being alike
+    std::size_t previousWordCount = 0;
+    // filled by the tokenizer, the views point into buffer
+    std::pmr::vector<std::string_view> words { memory->resource() };
+    // string_utilities::hashWord of each word, or of its key when there are keys
+    std::pmr::vector<std::uint64_t> hashes { memory->resource() };
+    // the distinct words of the chunk, the sketches of the chunks are merged in input order
+    HyperLogLog sketch;
+    // the points of each word under each scheme, points[word * schemeCount + scheme]
+    std::pmr::vector<int> points { memory->resource() };
+    // filled by the tokenizer when it records positions, for the report of invalid input:
+    // the place of each word in the buffer before the compaction, and the offsets of the line feeds
+    std::pmr::vector<WordPosition> wordPositions { memory->resource() };
+    std::pmr::vector<std::uint32_t> lineEnds { memory->resource() };
+    // the words and lines skipped or repaired, in input order
+    std::pmr::vector<InvalidInput> invalidInputs { memory->resource() };
+    // the repaired words, when the invalid sequences are replaced
+    std::pmr::string repairs { memory->resource() };
+    // the words changed by the NFC normalization
+    std::pmr::string normalizedWords { memory->resource() };
+    // the words are deduplicated on their keys when there are keys, lowercase copies of the words
+    // when the case is folded and the spelling kept
+    std::pmr::vector<std::string_view> keys { memory->resource() };
+    std::pmr::string lowercaseWords { memory->resource() };
+    // one slice per partition, when the words are deduplicated by partition
+    std::vector<PartitionSlice> partitionSlices;
+};
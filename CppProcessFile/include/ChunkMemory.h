@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// the memory of the containers of a chunk, a monotonic_buffer_resource: an allocation is a pointer bump, a deallocation
+// does nothing, and everything is released at once before the chunk is filled again
+// the resource starts on a buffer kept between the chunks, which grows to what the largest chunk took, so that once
+// the first chunks are through the upstream resource is not called anymore
+class ChunkMemory
+{
+public:
+    // upstream is called by the thread working on the chunk, so it must be thread safe when there are several chunks,
+    // as the default resource is
+    explicit ChunkMemory(std::pmr::memory_resource* upstream);
+    ChunkMemory(const ChunkMemory&)            = delete;
+    ChunkMemory& operator=(const ChunkMemory&) = delete;
+    ~ChunkMemory();
+
+    std::pmr::memory_resource* resource()
+    {
+        return &*monotonic;
+    }
+
+    std::pmr::memory_resource* upstream() const
+    {
+        return overflow.upstream;
+    }
+
+    // the containers taking their memory from resource() must have freed it first, see chunk_memory::freeContainer
+    void release();
+
+private:
+    // forwards to upstream, and counts what the monotonic resource takes once the buffer is full
+    class OverflowCounter : public std::pmr::memory_resource
+    {
+    public:
+        explicit OverflowCounter(std::pmr::memory_resource* upstream);
+
+        std::pmr::memory_resource* upstream;
+        std::size_t takenSize = 0;
+
+    private:
+        void* do_allocate(std::size_t size, std::size_t alignment) override;
+        void do_deallocate(void* memory, std::size_t size, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    OverflowCounter overflow;
+    std::byte* buffer      = nullptr;
+    std::size_t bufferSize = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic;
+};
+
+namespace chunk_memory
+{
+    // gives the memory of the container back to its resource, where clear() would keep it, and so would the move
+    // assignment of an empty string, which copies its characters into the storage in place
+    template <typename Container>
+    void freeContainer(Container& container)
+    {
+        const auto allocator = container.get_allocator();
+        std::destroy_at(&container);
+        std::construct_at(&container, allocator);
+    }
+} // namespace chunk_memory
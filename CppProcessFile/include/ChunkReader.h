@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Chunk.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// cuts the input into chunks after their last whitespace, the cut word is carried to the next chunk
+// when cutting at line ends, the chunks end after their last line feed, and a line is only split when it
+// is longer than a chunk
+// it does not read by itself: the caller reads into nextRead and reports the byte count to commit,
+// so that the same cutting serves the blocking reader thread and the awaiting coroutines
+class ChunkReader
+{
+public:
+    explicit ChunkReader(std::size_t chunkSize, bool cutsAtLineEnds = false);
+
+    // starts the chunk with the bytes carried from the previous one
+    // what the chunk held from its previous use is released with its memory
+    void begin(Chunk& chunk);
+    std::span<char> nextRead(Chunk& chunk) const;
+    // returns true once the chunk is complete, a read of 0 bytes marks the end of the input
+    bool commit(Chunk& chunk, std::size_t readCount);
+    bool isEndOfInput() const;
+    // the number of completed chunks
+    std::size_t chunkCount() const;
+
+private:
+    bool finish(Chunk& chunk, std::size_t size);
+
+    std::size_t chunkSize;
+    bool cutsAtLineEnds;
+    std::vector<char> carry;
+    // chunk size when the current round of chunkSize bytes started
+    std::size_t roundStart    = 0;
+    std::size_t sequence      = 0;
+    std::uint64_t inputOffset = 0;
+    bool endOfInput           = false;
+};
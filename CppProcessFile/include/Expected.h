@@ -0,0 +1,101 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// the kinds of failure reported by the engine, the command line tool turns each into its exception
+enum class ErrorCode
+{
+    FileOpen,
+    FileRead,
+    NonUtf8Characters,
+    ScoringScheme
+};
+
+struct Error
+{
+    ErrorCode code;
+    std::string message;
+};
+
+// a value, or the error that prevented it, in the manner of std::expected which C++20 does not have
+// the engine returns its failures this way instead of throwing, so that it builds with -fno-exceptions
+template <typename T>
+class [[nodiscard]] Expected
+{
+public:
+    template <typename U = T>
+        requires std::is_convertible_v<U, T>
+    Expected(U&& value) : result(std::in_place_index<0>, std::forward<U>(value))
+    {
+    }
+    Expected(Error error) : result(std::in_place_index<1>, std::move(error))
+    {
+    }
+
+    bool hasValue() const
+    {
+        return result.index() == 0;
+    }
+
+    explicit operator bool() const
+    {
+        return hasValue();
+    }
+
+    // the result must hold a value
+    T& operator*()
+    {
+        return *std::get_if<0>(&result);
+    }
+
+    const T& operator*() const
+    {
+        return *std::get_if<0>(&result);
+    }
+
+    T* operator->()
+    {
+        return std::get_if<0>(&result);
+    }
+
+    // the result must hold an error
+    const Error& error() const
+    {
+        return *std::get_if<1>(&result);
+    }
+
+private:
+    std::variant<T, Error> result;
+};
+
+template <>
+class [[nodiscard]] Expected<void>
+{
+public:
+    Expected() = default;
+    Expected(Error error) : failure(std::move(error))
+    {
+    }
+
+    bool hasValue() const
+    {
+        return !failure.has_value();
+    }
+
+    explicit operator bool() const
+    {
+        return hasValue();
+    }
+
+    const Error& error() const
+    {
+        return *failure;
+    }
+
+private:
+    std::optional<Error> failure;
+};
@@ -1,25 +1,110 @@
-#pragma once
-
-#include <fstream>
-#include <string>
-#include <string_view>
-#include <unordered_set>
-#include <utility>
-#include <vector>
-
-class FileProcessor
-{
-public:
-    void process(const std::string& inputPath, const std::string& outputPath) const;
-    void processWordWithoutDuplicates(const std::string& word,
-        std::unordered_set<std::string_view>& hashSetProcessedWords,
-        std::vector<std::pair<std::string, int>>& pairingUniqueWordsToPoints) const;
-    void validateEncoding(const std::string& word) const;
-    void processWordForPairingToPoints(
-        const std::string& word, std::vector<std::pair<std::string, int>>& pairingUniqueWordsToPoints) const;
-    std::vector<std::pair<std::string, int>> createPairingUniqueWordsToPoints(const std::string& outputPath) const;
-    void createSortedOutputFile(
-        const std::string& outputPath, std::vector<std::pair<std::string, int>>& pairingUniqueWordsToPoints) const;
-    bool splitWordOnMultiByteApostrophe(const std::string& word, std::vector<std::string>& splitWords) const;
-    int countPoints(const std::string& word) const;
-};
+#pragma once
+
+#include "ByteSource.h"
+#include "Chunk.h"
+#include "Expected.h"
+#include "HyperLogLog.h"
+#include "ProcessingOptions.h"
+#include "Task.h"
+#include "UniqueWords.h"
+#include "WordBatch.h"
+#include "WordSet.h"
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class BlockingCallPool;
+class ChunkReader;
+class ScoringScheme;
+class WorkStealingScheduler;
+
+// what --stats reports for a file
+struct FileStats
+{
+    std::size_t wordCount       = 0;
+    std::size_t uniqueWordCount = 0;
+    // the HyperLogLog estimate of the unique words
+    std::size_t estimatedUniqueWordCount = 0;
+};
+
+class FileProcessor
+{
+public:
+    FileProcessor();
+    // memory is the upstream of the chunk memories and the resource of the arrays of the results, the caller
+    // keeps it alive as long as the processor and its results, and it must be thread safe, as the default resource is
+    explicit FileProcessor(
+        const ProcessingOptions& options, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    ~FileProcessor();
+
+    // fails when two outputs or reports of the files are the same file, as a scheme named "invalid" and the report
+    // of the invalid input, or the same input given twice: one would overwrite the other
+    Expected<void> checkOutputPaths(const std::vector<std::pair<std::string, std::string>>& inputAndOutputPaths) const;
+    // processes the files concurrently, as jobs of the scheduler
+    // every file is processed, the error of the first file that failed is returned, else the stats of each file
+    Expected<std::vector<FileStats>> processFiles(
+        const std::vector<std::pair<std::string, std::string>>& inputAndOutputPaths) const;
+    Expected<FileStats> process(const std::string& inputPath, const std::string& outputPath) const;
+    // the input file through the backend and the decoder of the options
+    Expected<std::unique_ptr<ByteSource>> openInput(const std::string& inputPath) const;
+    // the awaitable counterpart of createPairingUniqueWordsToPoints, it never blocks a worker on a read
+    // uniqueWordCapacity sizes the ordered deduplication, 0 lets it grow
+    Task<Expected<UniqueWords>> processAsync(ByteSource& input, std::size_t uniqueWordCapacity = 0) const;
+    Task<Expected<FileStats>> processFileAsync(std::string inputPath, std::string outputPath) const;
+    // fills the chunk from the input, suspending while it is read
+    Task<Expected<void>> readChunkAsync(ByteSource& input, ChunkReader& chunkReader, Chunk& chunk) const;
+    // the first pass of options.presizeTables: the input is only tokenized, and its words hashed into a sketch
+    // the keys of --fold-case=keep-spelling are not made, each spelling counts, so the estimate can only be larger
+    Expected<HyperLogLog> sketchInput(const std::string& inputPath) const;
+    Task<Expected<HyperLogLog>> sketchInputAsync(std::string inputPath) const;
+    Expected<void> tokenizeAndScore(Chunk& chunk) const;
+    // validates the words and adds their points under each scheme, points[word * schemeCount + scheme]
+    // returns the index of the first invalid word of the batch, word_batch::NO_INVALID_WORD if there is none
+    std::size_t scoreBatch(const WordBatch& batch, std::span<int> points) const;
+    // applies the invalid input policy to the listed words, in increasing order
+    void handleInvalidWords(Chunk& chunk, std::span<const std::size_t> invalidWords) const;
+    // the words that are not in NFC are replaced with their NFC form
+    void normalizeWords(Chunk& chunk) const;
+    // fills chunk.keys with the lowercase words, the words keep their spelling
+    void makeLowercaseKeys(Chunk& chunk) const;
+    // the listed words take their new spelling from storage, word i from offsets[i] to offsets[i + 1],
+    // and are scored again
+    void replaceWords(Chunk& chunk,
+        std::span<const std::size_t> words,
+        std::string_view storage,
+        std::span<const std::size_t> offsets) const;
+    // adds the invalid input, the words and the sketch of the chunk to uniqueWords, the chunks in input order
+    void collectChunkTotals(const Chunk& chunk, UniqueWords& uniqueWords) const;
+    // makes room for capacity unique words in the table and the arrays of the ordered deduplication
+    void reserveUniqueWords(std::size_t capacity, WordSet& hashSetProcessedWords, UniqueWords& uniqueWords) const;
+    void processChunkWithoutDuplicates(
+        const Chunk& chunk, WordSet& hashSetProcessedWords, UniqueWords& uniqueWords) const;
+    void processWordForPairingToPoints(ArenaWord word, std::span<const int> points, UniqueWords& uniqueWords) const;
+    Expected<UniqueWords> createPairingUniqueWordsToPoints(const std::string& inputPath) const;
+    // the same unique words as createPairingUniqueWordsToPoints, deduplicated by PartitionedDeduplicator
+    Expected<UniqueWords> createPairingUniqueWordsByPartition(ByteSource& input) const;
+    // one output per scoring scheme, the scheme name is inserted before the extension when there are several
+    std::vector<std::string> getOutputPaths(const std::string& outputPath) const;
+    Expected<void> createSortedOutputFiles(const std::string& outputPath, const UniqueWords& uniqueWords) const;
+    // the offset and the length of each word or line skipped or repaired, one per line
+    std::string getInvalidInputReportPath(const std::string& outputPath) const;
+    Expected<void> createInvalidInputReport(const std::string& outputPath, const UniqueWords& uniqueWords) const;
+
+private:
+    // with a column of points per scheme, and an arena allocated as the options ask
+    UniqueWords createUniqueWords() const;
+
+    ProcessingOptions options;
+    std::pmr::memory_resource* memory;
+    std::vector<std::shared_ptr<const ScoringScheme>> scoringSchemes;
+    // no scheme file was given, DefaultScorer replaces the default scheme
+    bool useDefaultScorer = false;
+    std::unique_ptr<WorkStealingScheduler> scheduler;
+    std::unique_ptr<BlockingCallPool> blockingCalls;
+};
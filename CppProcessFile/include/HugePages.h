@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace huge_pages
+{
+    // the size of a huge page on x86-64, and on arm64 with pages of 4 KiB
+    constexpr std::size_t HUGE_PAGE_SIZE = std::size_t { 2 } << 20;
+    // a smaller allocation would waste most of its huge page
+    constexpr std::size_t MIN_SIZE = HUGE_PAGE_SIZE / 2;
+
+    // the size rounded up to whole huge pages: explicit huge pages when the system has some reserved, else a mapping
+    // aligned on a huge page and advised to be backed by transparent huge pages, which the kernel does when it can
+    // elsewhere than on Linux, memory from operator new
+    void* allocate(std::size_t size);
+    void deallocate(void* memory, std::size_t size);
+} // namespace huge_pages
+
+// allocates the big arrays on huge pages when asked to, and everything else with operator new
+// the choice belongs to the allocator, and so to the container, which frees its memory the way it was allocated
+template <typename T>
+class HugePageAllocator
+{
+public:
+    using value_type                             = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    HugePageAllocator() = default;
+
+    explicit HugePageAllocator(bool usesHugePages) : usesHugePages(usesHugePages)
+    {
+    }
+
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>& other) : usesHugePages(other.usesHugePages)
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        if (isHuge(count)) {
+            return static_cast<T*>(huge_pages::allocate(count * sizeof(T)));
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* memory, std::size_t count)
+    {
+        if (isHuge(count)) {
+            huge_pages::deallocate(memory, count * sizeof(T));
+        } else {
+            std::allocator<T>().deallocate(memory, count);
+        }
+    }
+
+    bool operator==(const HugePageAllocator& other) const = default;
+
+private:
+    template <typename U>
+    friend class HugePageAllocator;
+
+    bool isHuge(std::size_t count) const
+    {
+        return usesHugePages && count * sizeof(T) >= huge_pages::MIN_SIZE;
+    }
+
+    bool usesHugePages = false;
+};
+
+template <typename T>
+using HugePageVector = std::vector<T, HugePageAllocator<T>>;
+
+// bytes from HugePageAllocator, left uninitialized as make_unique_for_overwrite leaves them
+class PageBuffer
+{
+public:
+    PageBuffer(std::size_t size, bool usesHugePages);
+    PageBuffer(PageBuffer&& other) noexcept;
+    PageBuffer& operator=(PageBuffer&& other) noexcept;
+    ~PageBuffer();
+
+    char* data() const
+    {
+        return bytes;
+    }
+
+private:
+    HugePageAllocator<char> allocator;
+    char* bytes      = nullptr;
+    std::size_t size = 0;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ByteSource.h"
+
+#include <memory>
+
+enum class InputEncoding
+{
+    Utf8,
+    Latin1,
+    Cp1252,
+    Utf16Le,
+    Utf16Be,
+    Auto
+};
+
+// decodes the input to UTF-8 in front of the tokenizer, block by block as it is read
+// Utf8 passes the bytes through, without the byte order mark if the input starts with one
+// Auto looks at the first block: a byte order mark tells UTF-8 or UTF-16, without it the input is taken
+// as UTF-8 when the block is valid UTF-8, as Windows-1252 otherwise
+Expected<std::unique_ptr<ByteSource>> decodeInput(std::unique_ptr<ByteSource> source, InputEncoding encoding);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// what becomes of the words that are not valid UTF-8
+enum class InvalidInputPolicy
+{
+    // the processing stops with NonUtf8CharactersFoundException
+    Abort,
+    SkipWord,
+    // the line of the word is left out, the chunks are then cut at line ends
+    SkipLine,
+    // each invalid sequence becomes U+FFFD
+    Replace
+};
+
+// a word or a line skipped or repaired, reported with its place in the decoded input
+struct InvalidInput
+{
+    std::uint64_t inputOffset;
+    std::uint32_t length;
+};
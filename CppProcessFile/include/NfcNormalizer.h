@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// brings words to the Unicode normalization form C, so that a precomposed letter and the same letter
+// followed by a combining mark make the same word with the same points
+// the characters below U+0300 (ASCII, Latin-1 and the Latin extensions) are in NFC in any order, so the words
+// made of them only are recognized from their bytes, and only the others are decomposed and recomposed
+class NfcNormalizer
+{
+public:
+    // true when the word has no character from U+0300 up, such a word is in NFC
+    static bool isQuickNfc(std::string_view word);
+    // appends the NFC form of the word to destination when it differs from the word, and returns true
+    // the word must be valid UTF-8, a word in NFC already leaves destination as it is
+    bool appendNormalized(std::string_view word, std::pmr::string& destination);
+
+private:
+    void decompose(char32_t codepoint);
+    void reorderMarks();
+    void compose();
+
+    // reused from word to word
+    std::vector<char32_t> original;
+    std::vector<char32_t> codepoints;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the NUMA nodes of the machine, read from sysfs so that libnuma is not needed
+// the memory of a node is placed by first touch: the kernel takes the pages from the node of the thread
+// that writes them first, so a buffer is local to the node whose workers touch it first
+namespace numa
+{
+    // the cores of each node that has cores, from root/online and root/node<n>/cpulist
+    // one node with every core when the directory is missing, off Linux or in some containers
+    std::vector<std::vector<unsigned>> nodeCores(const std::string& root = "/sys/devices/system/node");
+    // a list as the kernel writes them, "0-3,8,10-11"
+    std::vector<unsigned> parseList(std::string_view list);
+} // namespace numa
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Chunk.h"
+#include "UniqueWords.h"
+#include "WordArena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class WorkStealingScheduler;
+
+enum class DeduplicationMode
+{
+    // one table, filled in input order by the consuming stage of the pipeline
+    Ordered,
+    // no table shared between threads, see PartitionedDeduplicator
+    Partitioned
+};
+
+// deduplicates without any table shared between threads
+// the words of each chunk are split by hash into partitions, in the parallel stage of the pipeline, so that a word
+// and all its duplicates fall into the same partition, then each partition is deduplicated by one task with a WordSet
+// of its own. the unique words of the partitions are merged back in order of first occurrence, so the result is the
+// one of the ordered deduplication
+// on a NUMA machine, the partitions are shared out between the nodes, whose workers build their tables in local
+// memory, and the merge gathers the partial results of the nodes
+class PartitionedDeduplicator
+{
+public:
+    static constexpr unsigned PARTITION_BITS = 6;
+
+    explicit PartitionedDeduplicator(std::size_t schemeCount, bool usesHugePages = false);
+
+    // fills one slice per partition with the words of the tokenized chunk, several chunks can be split at once
+    // the slices take their memory from the upstream resource of the chunk memory
+    void split(const Chunk& chunk, std::vector<PartitionSlice>& slices) const;
+    // the slices of each chunk, in input order
+    void append(std::vector<PartitionSlice>&& slices);
+    // deduplicates the partitions as tasks of the scheduler, and adds their unique words to uniqueWords
+    // the tables are sized from uniqueWords.sketch, which must hold the words of all the chunks
+    void finish(WorkStealingScheduler& scheduler, UniqueWords& uniqueWords);
+
+private:
+    static constexpr std::size_t PARTITION_COUNT = std::size_t { 1 } << PARTITION_BITS;
+
+    // the unique words of a partition, in order of first occurrence
+    struct Partition
+    {
+        WordArena arena;
+        // the chunk in the high 32 bits, the index of the word in the chunk in the low ones
+        std::vector<std::uint64_t> positions;
+        std::vector<ArenaWord> words;
+        std::vector<int> points;
+    };
+
+    // the bits under the 7 of the WordSet tag, which the group index of a table never reaches
+    static std::size_t partitionOf(std::uint64_t hash);
+    void deduplicate(std::size_t partitionIndex, std::size_t capacity, Partition& partition);
+    void merge(std::vector<Partition>& partitions, UniqueWords& uniqueWords) const;
+
+    std::size_t schemeCount;
+    // for the tables and the arenas of the partitions, the tables of the chunks are small and short-lived
+    bool usesHugePages;
+    // slices[chunk][partition]
+    std::vector<std::vector<PartitionSlice>> slices;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ByteSource.h"
+#include "CaseFolding.h"
+#include "InputEncoding.h"
+#include "InvalidInput.h"
+#include "PartitionedDeduplicator.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class ScoringScheme;
+
+struct ProcessingOptions
+{
+    // bytes read from the input per chunk
+    std::size_t chunkSize = 1 << 20;
+    // chunk buffers in flight, this caps the memory used by the pipeline
+    std::size_t chunkCount = 8;
+    // 0 selects the number of hardware threads
+    unsigned threadCount = 0;
+    // binds each worker of the scheduler to a core
+    bool pinWorkers = false;
+    // spreads the workers over the NUMA nodes, see ProcessingPipeline and PartitionedDeduplicator
+    bool spreadOverNodes = false;
+    IoBackend ioBackend  = IoBackend::Stream;
+    // the chunk buffers, the tables of the deduplication and the arenas of the words are allocated on huge pages
+    bool useHugePages = false;
+    // the input is decoded to UTF-8 before the tokenizer
+    InputEncoding inputEncoding           = InputEncoding::Utf8;
+    InvalidInputPolicy invalidInputPolicy = InvalidInputPolicy::Abort;
+    // the words are brought to NFC before they are deduplicated, and scored in that form
+    bool normalizeToNfc     = false;
+    CaseFolding caseFolding = CaseFolding::Off;
+    // the partitioned deduplication spreads the work of the table over the workers
+    DeduplicationMode deduplicationMode = DeduplicationMode::Ordered;
+    // a first pass over the input estimates the unique words, the table and the arrays of the ordered deduplication
+    // are sized for them at once instead of growing, the partitioned deduplication sizes its tables without it
+    bool presizeTables = false;
+    // the number of words, of unique words and the estimate are reported for each file
+    bool printsStats = false;
+    // processes the files as coroutines, the reads run on ioThreadCount threads of their own
+    bool useAsync          = false;
+    unsigned ioThreadCount = 2;
+    // all the schemes are scored in the same pass, none selects ScoringScheme::defaultScheme
+    std::vector<std::shared_ptr<const ScoringScheme>> scoringSchemes;
+};
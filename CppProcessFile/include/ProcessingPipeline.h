@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ByteSource.h"
+#include "Chunk.h"
+#include "Expected.h"
+#include "ProcessingOptions.h"
+#include "RingBuffer.h"
+#include "WorkStealingScheduler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// reads the input on a reader thread, tokenizes the chunks as tasks of the scheduler,
+// and hands them to the consuming stage on the calling thread in input order
+// the tokenized chunks come back through a bounded lock-free ring, the consumed chunk buffers go back
+// to the reader through another one, and the fixed number of buffers makes the reader wait
+// when the other stages fall behind
+// the first error of a read or a stage stops the pipeline, and run returns it
+// when the workers are spread over NUMA nodes, each chunk buffer belongs to a node: it is first touched by a worker
+// of the node, which places its memory there, and the chunks read into it are tokenized by the workers of the node
+// the containers of each chunk take their memory from its ChunkMemory, released when the chunk is read again
+class ProcessingPipeline
+{
+public:
+    using ChunkStage = std::function<Expected<void>(Chunk&)>;
+
+    // memory is the upstream resource of the chunk memories
+    ProcessingPipeline(const ProcessingOptions& options,
+        WorkStealingScheduler& scheduler,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    Expected<void> run(ByteSource& input, const ChunkStage& tokenizeStage, const ChunkStage& consumeStage);
+
+private:
+    void readChunks(ByteSource& input, const ChunkStage& tokenizeStage);
+    void tokenizeChunk(std::uint32_t index, const ChunkStage& tokenizeStage);
+    void consumeChunks(const ChunkStage& consumeStage);
+    void abort(Error error);
+    unsigned nodeOf(std::uint32_t index) const;
+    void touchBuffers();
+
+    ProcessingOptions options;
+    WorkStealingScheduler& scheduler;
+    TaskGroup tokenizeTasks;
+    std::vector<Chunk> chunks;
+    // tokenizers -> consumer
+    MpmcRingBuffer<std::uint32_t> tokenizedChunks;
+    // consumer -> reader
+    SpscRingBuffer<std::uint32_t> freeChunks;
+    // set by the reader when it reaches the end of the input
+    std::atomic<std::size_t> chunkTotal = 0;
+    std::atomic<bool> readerFinished    = false;
+    std::atomic<bool> aborted           = false;
+    std::mutex errorMutex;
+    std::optional<Error> firstError;
+};
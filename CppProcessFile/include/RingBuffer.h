@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// bounded lock-free ring buffers used to connect the stages of the processing pipeline
+// the element type is meant to be a small descriptor (an index, a pointer), not a payload
+
+// keeps the producer and the consumer indices on different cache lines
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// spins a little, then yields, so that a stage waiting on a full or empty ring
+// leaves the core to the other stages when there are more threads than cores
+class RingBufferBackoff
+{
+public:
+    void pause()
+    {
+        if (spins < SPIN_LIMIT) {
+            ++spins;
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+private:
+    static constexpr int SPIN_LIMIT = 64;
+    int spins                       = 0;
+};
+
+// blocking push and pop on top of tryPush and tryPop of the derived ring
+template <typename Derived, typename T>
+class RingBufferBase
+{
+public:
+    // blocks while the ring is full, returns false if the ring is closed meanwhile
+    bool push(const T& value)
+    {
+        RingBufferBackoff backoff;
+        while (!derived().tryPush(value)) {
+            if (isClosed()) {
+                return false;
+            }
+            backoff.pause();
+        }
+        return true;
+    }
+
+    // blocks while the ring is empty, returns false once the ring is closed and drained
+    bool pop(T& value)
+    {
+        RingBufferBackoff backoff;
+        while (!derived().tryPop(value)) {
+            if (isClosed()) {
+                // an element pushed just before closing must still be delivered
+                return derived().tryPop(value);
+            }
+            backoff.pause();
+        }
+        return true;
+    }
+
+    void close()
+    {
+        closed.store(true, std::memory_order_release);
+    }
+
+    bool isClosed() const
+    {
+        return closed.load(std::memory_order_acquire);
+    }
+
+private:
+    Derived& derived()
+    {
+        return static_cast<Derived&>(*this);
+    }
+
+    std::atomic<bool> closed = false;
+};
+
+// single producer, single consumer
+template <typename T>
+class SpscRingBuffer : public RingBufferBase<SpscRingBuffer<T>, T>
+{
+public:
+    explicit SpscRingBuffer(std::size_t capacity) :
+        mask(std::bit_ceil(capacity < 2 ? 2 : capacity) - 1),
+        slots(std::make_unique<T[]>(mask + 1))
+    {
+    }
+
+    bool tryPush(const T& value)
+    {
+        const std::size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - cachedHead > mask) {
+            cachedHead = headIndex.load(std::memory_order_acquire);
+            if (tail - cachedHead > mask) {
+                return false;
+            }
+        }
+        slots[tail & mask] = value;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        const std::size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tailIndex.load(std::memory_order_acquire);
+            if (head == cachedTail) {
+                return false;
+            }
+        }
+        value = slots[head & mask];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    const std::size_t mask;
+    std::unique_ptr<T[]> slots;
+    // written by the producer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tailIndex = 0;
+    std::size_t cachedHead                                       = 0;
+    // written by the consumer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> headIndex = 0;
+    std::size_t cachedTail                                       = 0;
+};
+
+// multiple producers, multiple consumers
+// each slot carries a sequence number telling whether it is ready to be written or read
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+template <typename T>
+class MpmcRingBuffer : public RingBufferBase<MpmcRingBuffer<T>, T>
+{
+public:
+    explicit MpmcRingBuffer(std::size_t capacity) :
+        mask(std::bit_ceil(capacity < 2 ? 2 : capacity) - 1),
+        slots(std::make_unique<Slot[]>(mask + 1))
+    {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(const T& value)
+    {
+        std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Slot* slot           = nullptr;
+        while (true) {
+            slot                        = &slots[position & mask];
+            const std::size_t sequence  = slot->sequence.load(std::memory_order_acquire);
+            const std::intptr_t balance = static_cast<std::intptr_t>(sequence - position);
+            if (balance == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (balance < 0) {
+                return false;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        Slot* slot           = nullptr;
+        while (true) {
+            slot                        = &slots[position & mask];
+            const std::size_t sequence  = slot->sequence.load(std::memory_order_acquire);
+            const std::intptr_t balance = static_cast<std::intptr_t>(sequence - (position + 1));
+            if (balance == 0) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (balance < 0) {
+                return false;
+            } else {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        value = slot->value;
+        slot->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> enqueuePosition = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> dequeuePosition = 0;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Alphabet.h"
+#include "Expected.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the points of each letter, compiled into a dense two-level table indexed by the code point
+// the first level maps the high bits of the code point to a block of 256 points, the blocks without
+// any scored letter share one block of zeros, so a lookup is two loads whatever the scheme
+// schemes are independent objects, several of them can live in one process
+class ScoringScheme
+{
+public:
+    using Entry = LetterPoints;
+
+    ScoringScheme(std::string name, std::span<const Entry> entries);
+
+    // the runtime counterpart of DefaultScorer, built from defaultAlphabet
+    static std::shared_ptr<const ScoringScheme> defaultScheme();
+    // one letter and its points per line, separated by a tab, the letter is a UTF-8 character or U+XXXX
+    // empty lines and lines starting with # are ignored
+    static Expected<std::shared_ptr<const ScoringScheme>> loadFromFile(const std::string& path);
+
+    const std::string& getName() const;
+    // the word must be valid UTF-8
+    int countPoints(std::string_view word) const;
+
+    // any character missing from the scheme counts as 0
+    int points(char32_t codepoint) const
+    {
+        if (codepoint > MAX_CODEPOINT) {
+            return 0;
+        }
+        return blockPoints[(static_cast<std::size_t>(blockIndices[codepoint >> BLOCK_BITS]) << BLOCK_BITS) |
+                           (codepoint & BLOCK_MASK)];
+    }
+
+private:
+    static constexpr char32_t MAX_CODEPOINT = 0x10FFFF;
+    static constexpr unsigned BLOCK_BITS    = 8;
+    static constexpr char32_t BLOCK_MASK    = (1 << BLOCK_BITS) - 1;
+
+    std::string name;
+    std::vector<std::uint16_t> blockIndices;
+    // block 0 is the shared block of zeros
+    std::vector<int> blockPoints;
+};
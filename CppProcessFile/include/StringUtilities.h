@@ -1,116 +1,274 @@
-﻿#include <algorithm>
-#include <cstddef>
-#include <iostream>
-#include <string>
-#include <string_view>
-
-namespace string_utilities
-{
-
-    // https://stackoverflow.com/questions/75070990/c17-check-if-a-file-is-encoded-in-utf-8
-    size_t find_first_not_utf8(std::string_view s)
-    {
-        // ----------------------------------------------------
-        // returns true if fn(c) returns true for all n first charac-ters c of
-        // string src. the sring_voew is updated to exclude the first n characters
-        // if a match is found, left untouched otherwise.
-        const auto match_n = [](std::string_view& src, size_t n, auto&& fn) noexcept {
-            if (src.length() < n)
-                return false;
-
-            if (!std::all_of(src.begin(), src.begin() + n, fn))
-                return false;
-
-            src.remove_prefix(n);
-            return true;
-        };
-
-        // ----------------------------------------------------
-        // returns true if fn(c) returns true for the first character c of
-        // string src. the sring_view is updated to exclude the first character
-        // if a match is found, left untouched otherwise.
-        const auto match_1 = [](std::string_view& src, auto&& fn) noexcept {
-            if (src.empty())
-                return false;
-
-            if (!fn(src.front()))
-                return false;
-
-            src.remove_prefix(1);
-            return true;
-        };
-
-        // ----------------------------------------------------
-        // returns true if the first chatacter sequence of src is a valid non-ascii
-        // utf8 sequece.
-        // the sring_view is updated to exclude the first utf-8 sequence if non-ascii
-        // sequence is found, left untouched otherwise.
-
-        const auto utf8_non_ascii = [&](std::string_view& src) noexcept {
-            const auto SRC = src;
-
-            auto UTF8_CONT = [](uint8_t c) noexcept { return 0x80 <= c && c <= 0xBF; };
-
-            if (match_1(src, [](uint8_t c) { return 0xC0 <= c && c <= 0xDF; }) && match_1(src, UTF8_CONT)) {
-                return true;
-            }
-            src = SRC;
-            if (match_1(src, [](uint8_t c) { return 0xE0 <= c && c <= 0xEF; }) && match_n(src, 2, UTF8_CONT)) {
-                return true;
-            }
-            src = SRC;
-            if (match_1(src, [](uint8_t c) { return 0xF0 <= c && c <= 0xF7; }) && match_n(src, 3, UTF8_CONT)) {
-                return true;
-            }
-            src = SRC;
-            if (match_1(src, [](uint8_t c) { return 0xF8 <= c && c <= 0xFB; }) && match_n(src, 4, UTF8_CONT)) {
-                return true;
-            }
-            src = SRC;
-            if (match_1(src, [](uint8_t c) { return 0xFC <= c && c <= 0xFD; }) && match_n(src, 5, UTF8_CONT)) {
-                return true;
-            }
-            src = SRC;
-            return false;
-        };
-
-        // ----------------------------------------------------
-        // returns true if the first symbol of st(ring src is a valid UTF8 character
-        // not-including control characters, nor space.
-        // the sring_view is updated to exclude the first utf-8 sequence
-        // if a valid symbol sequence is found, left untouched otherwise.
-
-        const auto utf8_char = [&](std::string_view& src) noexcept {
-            auto rule = [](uint8_t c) noexcept -> bool { return (0x21 <= c && c <= 0x7E) || std::isspace(c); };
-
-            const auto SRC = src;
-
-            if (match_1(src, rule))
-                return true;
-            s = SRC;
-            return utf8_non_ascii(src);
-        };
-
-        // ----------------------------------------------------
-
-        const auto S = s;
-        while (!s.empty() && utf8_char(s)) {
-        }
-
-        if (s.empty())
-            return std::string_view::npos;
-
-        return size_t(s.data() - S.data());
-    }
-
-    // https://gist.github.com/GenesisFR/cceaf433d5b42dcdddecdddee0657292
-    static std::string replaceAll(std::string str, const std::string& from, const std::string& to)
-    {
-        size_t start_pos = 0;
-        while ((start_pos = str.find(from, start_pos)) != std::string::npos) {
-            str.replace(start_pos, from.length(), to);
-            start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
-        }
-        return str;
-    }
-} // namespace string_utilities
+﻿#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace string_utilities
+{
+
+    // https://stackoverflow.com/questions/75070990/c17-check-if-a-file-is-encoded-in-utf-8
+    inline size_t find_first_not_utf8(std::string_view s)
+    {
+        // ----------------------------------------------------
+        // returns true if fn(c) returns true for all n first charac-ters c of
+        // string src. the sring_voew is updated to exclude the first n characters
+        // if a match is found, left untouched otherwise.
+        const auto match_n = [](std::string_view& src, size_t n, auto&& fn) noexcept {
+            if (src.length() < n)
+                return false;
+
+            if (!std::all_of(src.begin(), src.begin() + n, fn))
+                return false;
+
+            src.remove_prefix(n);
+            return true;
+        };
+
+        // ----------------------------------------------------
+        // returns true if fn(c) returns true for the first character c of
+        // string src. the sring_view is updated to exclude the first character
+        // if a match is found, left untouched otherwise.
+        const auto match_1 = [](std::string_view& src, auto&& fn) noexcept {
+            if (src.empty())
+                return false;
+
+            if (!fn(src.front()))
+                return false;
+
+            src.remove_prefix(1);
+            return true;
+        };
+
+        // ----------------------------------------------------
+        // returns true if the first chatacter sequence of src is a valid non-ascii
+        // utf8 sequece.
+        // the sring_view is updated to exclude the first utf-8 sequence if non-ascii
+        // sequence is found, left untouched otherwise.
+
+        const auto utf8_non_ascii = [&](std::string_view& src) noexcept {
+            const auto SRC = src;
+
+            auto UTF8_CONT = [](uint8_t c) noexcept { return 0x80 <= c && c <= 0xBF; };
+
+            if (match_1(src, [](uint8_t c) { return 0xC0 <= c && c <= 0xDF; }) && match_1(src, UTF8_CONT)) {
+                return true;
+            }
+            src = SRC;
+            if (match_1(src, [](uint8_t c) { return 0xE0 <= c && c <= 0xEF; }) && match_n(src, 2, UTF8_CONT)) {
+                return true;
+            }
+            src = SRC;
+            if (match_1(src, [](uint8_t c) { return 0xF0 <= c && c <= 0xF7; }) && match_n(src, 3, UTF8_CONT)) {
+                return true;
+            }
+            src = SRC;
+            if (match_1(src, [](uint8_t c) { return 0xF8 <= c && c <= 0xFB; }) && match_n(src, 4, UTF8_CONT)) {
+                return true;
+            }
+            src = SRC;
+            if (match_1(src, [](uint8_t c) { return 0xFC <= c && c <= 0xFD; }) && match_n(src, 5, UTF8_CONT)) {
+                return true;
+            }
+            src = SRC;
+            return false;
+        };
+
+        // ----------------------------------------------------
+        // returns true if the first symbol of st(ring src is a valid UTF8 character
+        // not-including control characters, nor space.
+        // the sring_view is updated to exclude the first utf-8 sequence
+        // if a valid symbol sequence is found, left untouched otherwise.
+
+        const auto utf8_char = [&](std::string_view& src) noexcept {
+            auto rule = [](uint8_t c) noexcept -> bool { return (0x21 <= c && c <= 0x7E) || std::isspace(c); };
+
+            const auto SRC = src;
+
+            if (match_1(src, rule))
+                return true;
+            s = SRC;
+            return utf8_non_ascii(src);
+        };
+
+        // ----------------------------------------------------
+
+        const auto S = s;
+        while (!s.empty() && utf8_char(s)) {
+        }
+
+        if (s.empty())
+            return std::string_view::npos;
+
+        return size_t(s.data() - S.data());
+    }
+
+    // decodes the UTF-8 sequence starting at position and moves position past it
+    // the bytes must have been checked by find_first_not_utf8 beforehand
+    inline char32_t decodeUtf8(std::string_view s, size_t& position)
+    {
+        const auto lead = static_cast<unsigned char>(s[position++]);
+        if (lead < 0x80) {
+            return lead;
+        }
+        // the count of leading ones of the first byte is the length of the sequence
+        const int length   = std::countl_one(lead);
+        char32_t codepoint = lead & (0x7F >> length);
+        for (int i = 1; i < length && position < s.size(); ++i) {
+            codepoint = (codepoint << 6) | (static_cast<unsigned char>(s[position++]) & 0x3F);
+        }
+        return codepoint;
+    }
+
+    // writes the UTF-8 sequence of a code point up to U+10FFFF, returns its length
+    inline size_t encodeUtf8(char32_t codepoint, char* destination)
+    {
+        if (codepoint < 0x80) {
+            destination[0] = static_cast<char>(codepoint);
+            return 1;
+        }
+        if (codepoint < 0x800) {
+            destination[0] = static_cast<char>(0xC0 | (codepoint >> 6));
+            destination[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+            return 2;
+        }
+        if (codepoint < 0x10000) {
+            destination[0] = static_cast<char>(0xE0 | (codepoint >> 12));
+            destination[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            destination[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+            return 3;
+        }
+        destination[0] = static_cast<char>(0xF0 | (codepoint >> 18));
+        destination[1] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        destination[2] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        destination[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        return 4;
+    }
+
+    // the same set as std::isspace in the "C" locale
+    inline bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    // decodes the sequence at the start of bytes, with the rules of find_first_not_utf8
+    // returns its length, 0 if the sequence is invalid
+    inline size_t decodeUtf8Sequence(const char* bytes, size_t available, char32_t& codepoint)
+    {
+        const auto lead = static_cast<unsigned char>(bytes[0]);
+        if (lead < 0x80) {
+            codepoint = lead;
+            return (lead < 0x21 || lead == 0x7F) && !isWhitespace(bytes[0]) ? 0 : 1;
+        }
+        // 2 to 6 bytes, a continuation byte cannot start a sequence
+        const size_t length = std::countl_one(lead);
+        if (length < 2 || length > 6 || available < length) {
+            return 0;
+        }
+        codepoint = lead & (0x7F >> length);
+        for (size_t i = 1; i < length; ++i) {
+            const auto next = static_cast<unsigned char>(bytes[i]);
+            if ((next & 0xC0) != 0x80) {
+                return 0;
+            }
+            codepoint = (codepoint << 6) | (next & 0x3F);
+        }
+        return length;
+    }
+
+    // the length of the maximal invalid subpart at the start of bytes, where decodeUtf8Sequence returned 0:
+    // a lead byte and the continuation bytes after it, up to the length that it announces, else the single byte
+    inline size_t invalidSequenceLength(const char* bytes, size_t available)
+    {
+        const size_t length = std::countl_one(static_cast<unsigned char>(bytes[0]));
+        if (length < 2 || length > 6) {
+            return 1;
+        }
+        const size_t maxLength = std::min(length, available);
+        size_t invalidLength   = 1;
+        while (invalidLength < maxLength && (static_cast<unsigned char>(bytes[invalidLength]) & 0xC0) == 0x80) {
+            ++invalidLength;
+        }
+        return invalidLength;
+    }
+
+    // true if the 8 bytes are all printable ASCII, 0x21 to 0x7E, tested at once on a 64-bit word
+    inline bool isPrintableAscii(std::uint64_t bytes)
+    {
+        constexpr std::uint64_t ONES      = 0x0101010101010101;
+        constexpr std::uint64_t HIGH_BITS = 0x8080808080808080;
+        // with the high bits clear no addition carries into the next byte: a byte below 0x21 keeps its high bit
+        // clear once 0x5F is added, a byte above 0x7E gets it set once 1 is added
+        return ((bytes | ~(bytes + 0x5F * ONES) | (bytes + ONES)) & HIGH_BITS) == 0;
+    }
+
+    // validates and decodes the word in a single walk, without building any container
+    // each code point is handed to onCodepoint as soon as its sequence is checked
+    // runs of printable ASCII, the bulk of most texts, are checked 8 bytes at a time
+    // returns the position of the first invalid sequence, npos if there is none
+    template <typename OnCodepoint>
+    size_t decodeUtf8(std::string_view s, OnCodepoint&& onCodepoint)
+    {
+        size_t position = 0;
+        while (position < s.size()) {
+            if (s.size() - position >= sizeof(std::uint64_t)) {
+                std::uint64_t bytes = 0;
+                std::memcpy(&bytes, s.data() + position, sizeof(bytes));
+                if (isPrintableAscii(bytes)) {
+                    for (size_t i = 0; i < sizeof(bytes); ++i) {
+                        onCodepoint(static_cast<char32_t>(static_cast<unsigned char>(s[position + i])));
+                    }
+                    position += sizeof(bytes);
+                    continue;
+                }
+            }
+            char32_t codepoint  = 0;
+            const size_t length = decodeUtf8Sequence(s.data() + position, s.size() - position, codepoint);
+            if (length == 0) {
+                return position;
+            }
+            onCodepoint(codepoint);
+            position += length;
+        }
+        return std::string_view::npos;
+    }
+
+    // the hash of the words in the deduplication, 8 bytes per step, so that a word costs a few multiplications
+    // the last step spreads every byte over all the bits, the low bits and the high bits are used separately
+    inline std::uint64_t hashWord(std::string_view word)
+    {
+        constexpr std::uint64_t MULTIPLIER = 0x9E3779B97F4A7C15;
+        std::uint64_t hash                 = word.size() * MULTIPLIER;
+        const char* bytes                  = word.data();
+        size_t rest                        = word.size();
+        std::uint64_t block                = 0;
+        for (; rest > sizeof(block); rest -= sizeof(block), bytes += sizeof(block)) {
+            std::memcpy(&block, bytes, sizeof(block));
+            hash = std::rotl(hash ^ block, 31) * MULTIPLIER;
+        }
+        // the last 1 to 8 bytes are read with fixed-size loads rather than a call to memcpy, the loads overlap
+        // but read every byte, and the length is in the hash already
+        block = 0;
+        if (rest >= sizeof(std::uint32_t)) {
+            std::uint32_t first = 0;
+            std::uint32_t last  = 0;
+            std::memcpy(&first, bytes, sizeof(first));
+            std::memcpy(&last, bytes + rest - sizeof(last), sizeof(last));
+            block = first | (static_cast<std::uint64_t>(last) << 32);
+        } else if (rest > 0) {
+            block = static_cast<unsigned char>(bytes[0]) | (static_cast<unsigned char>(bytes[rest / 2]) << 8) |
+                    (static_cast<unsigned char>(bytes[rest - 1]) << 16);
+        }
+        hash = std::rotl(hash ^ block, 31) * MULTIPLIER;
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCD;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB93FE53A87F5;
+        return hash ^ (hash >> 33);
+    }
+} // namespace string_utilities
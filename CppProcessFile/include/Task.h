@@ -0,0 +1,287 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class Task;
+
+namespace task_detail
+{
+    // resumes the awaiting coroutine when the task completes
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) const noexcept
+        {
+            return finished.promise().continuation;
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    struct PromiseBase
+    {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr error;
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void unhandled_exception() noexcept
+        {
+            error = std::current_exception();
+        }
+    };
+
+    template <typename T>
+    struct Promise : PromiseBase
+    {
+        std::optional<T> value;
+
+        Task<T> get_return_object() noexcept;
+
+        template <typename U>
+        void return_value(U&& result)
+        {
+            value.emplace(std::forward<U>(result));
+        }
+
+        T takeResult()
+        {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct Promise<void> : PromiseBase
+    {
+        Task<void> get_return_object() noexcept;
+
+        void return_void() const noexcept
+        {
+        }
+
+        void takeResult() const
+        {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
+    // a coroutine nobody awaits, its frame goes away when it completes
+    struct DetachedCoroutine
+    {
+        struct promise_type
+        {
+            DetachedCoroutine get_return_object() const noexcept
+            {
+                return {};
+            }
+
+            std::suspend_never initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            std::suspend_never final_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void return_void() const noexcept
+            {
+            }
+
+            void unhandled_exception() const noexcept
+            {
+                std::terminate();
+            }
+        };
+    };
+} // namespace task_detail
+
+// a lazy coroutine: it starts when it is awaited, and resumes the awaiting coroutine when it completes
+// an exception thrown by the coroutine is rethrown to the awaiting coroutine
+template <typename T = void>
+class Task
+{
+public:
+    using promise_type = task_detail::Promise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle)
+    {
+    }
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr))
+    {
+    }
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume()
+    {
+        return handle.promise().takeResult();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace task_detail
+{
+    template <typename T>
+    Task<T> Promise<T>::get_return_object() noexcept
+    {
+        return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> Promise<void>::get_return_object() noexcept
+    {
+        return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+    }
+
+    template <typename T>
+    DetachedCoroutine completeInto(Task<T>& task, std::promise<T>& result)
+    {
+#if defined(__cpp_exceptions)
+        try {
+#endif
+            if constexpr (std::is_void_v<T>) {
+                co_await task;
+                result.set_value();
+            } else {
+                result.set_value(co_await task);
+            }
+#if defined(__cpp_exceptions)
+        } catch (...) {
+            result.set_exception(std::current_exception());
+        }
+#endif
+    }
+
+    struct WhenAllState
+    {
+        std::atomic<std::size_t> remaining = 0;
+        std::coroutine_handle<> continuation;
+        std::mutex errorMutex;
+        std::exception_ptr firstError;
+    };
+
+    // the last task to complete resumes the coroutine waiting for all of them
+    inline DetachedCoroutine completeOne(Task<void>& task, WhenAllState& state)
+    {
+#if defined(__cpp_exceptions)
+        try {
+            co_await task;
+        } catch (...) {
+            std::lock_guard lock(state.errorMutex);
+            if (!state.firstError) {
+                state.firstError = std::current_exception();
+            }
+        }
+#else
+        co_await task;
+#endif
+        if (--state.remaining == 0) {
+            state.continuation.resume();
+        }
+    }
+
+    struct WhenAllAwaiter
+    {
+        std::vector<Task<void>>& tasks;
+        WhenAllState& state;
+
+        bool await_ready() const noexcept
+        {
+            return tasks.empty();
+        }
+
+        // the count holds one more until all the tasks are started, so that none completes the wait too early
+        bool await_suspend(std::coroutine_handle<> awaiting)
+        {
+            state.continuation = awaiting;
+            state.remaining    = tasks.size() + 1;
+            for (Task<void>& task : tasks) {
+                completeOne(task, state);
+            }
+            return --state.remaining != 0;
+        }
+
+        void await_resume() const
+        {
+            if (state.firstError) {
+                std::rethrow_exception(state.firstError);
+            }
+        }
+    };
+} // namespace task_detail
+
+// starts all the tasks and completes when all of them have, the first exception is rethrown
+inline Task<void> whenAll(std::vector<Task<void>> tasks)
+{
+    task_detail::WhenAllState state;
+    co_await task_detail::WhenAllAwaiter{ tasks, state };
+}
+
+// runs the task and blocks the calling thread until it completes, for callers outside of any coroutine
+template <typename T>
+T syncWait(Task<T> task)
+{
+    std::promise<T> result;
+    std::future<T> completion = result.get_future();
+    task_detail::completeInto(task, result);
+    return completion.get();
+}
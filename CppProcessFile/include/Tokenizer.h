@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Chunk.h"
+
+class Tokenizer
+{
+public:
+    // the positions are needed to report invalid input, they cost a little on every word
+    explicit Tokenizer(bool recordsPositions = false, bool lowercases = false);
+
+    // splits the chunk on whitespace, removes ' and , and splits on the multi-byte apostrophe U+2019
+    // the words are compacted in place in the chunk buffer and listed in chunk.words
+    // the bytes are classified 64 at a time into bit masks, with SSE2 where there is, and the words are read from them
+    // chunk.wordPositions and chunk.lineEnds are filled when the positions are recorded
+    // the words are lowercased with case_folding::toLowercase when lowercases is set, then hashed into chunk.hashes
+    void tokenize(Chunk& chunk) const;
+
+private:
+    bool recordsPositions;
+    bool lowercases;
+};
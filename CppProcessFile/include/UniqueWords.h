@@ -0,0 +1,40 @@
+#pragma once
+
+#include "HyperLogLog.h"
+#include "InvalidInput.h"
+#include "WordArena.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// the unique words of the input in order of first occurrence, and their points under each scoring scheme
+// the points are stored as one column per scheme: pointsPerScheme[scheme][i] are the points of words[i]
+// a word takes 8 bytes and 4 per scheme, the words themselves are in the arena
+// the arrays take their memory from the resource given, the arena from its own buffers
+struct UniqueWords
+{
+    UniqueWords() = default;
+
+    explicit UniqueWords(std::pmr::memory_resource* memory) :
+        words(memory), pointsPerScheme(memory), invalidInputs(memory)
+    {
+    }
+
+    std::string_view word(std::size_t i) const
+    {
+        return arena.view(words[i]);
+    }
+
+    WordArena arena;
+    std::pmr::vector<ArenaWord> words;
+    // the columns get the resource of the array as they are made
+    std::pmr::vector<std::pmr::vector<int>> pointsPerScheme;
+    // the words and lines skipped or repaired, in input order
+    std::pmr::vector<InvalidInput> invalidInputs;
+    // the words of the input, repeated ones included
+    std::size_t wordCount = 0;
+    // the estimate of the unique words, gathered from the chunks as they come
+    HyperLogLog sketch;
+};
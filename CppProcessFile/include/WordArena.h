@@ -0,0 +1,65 @@
+#pragma once
+
+#include "HugePages.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// a word of a WordArena in 8 bytes, where a view takes 16: its position, the block in the high 24 bits and the offset
+// in the block in the low 16, and its length
+// a word longer than the length field holds has a block of its own, and spans it
+struct ArenaWord
+{
+    std::uint64_t position : 40;
+    std::uint64_t length : 24;
+};
+
+// append-only storage for the unique words
+// the words are never moved, so the views of the words stay valid as long as the arena lives
+// on huge pages, the blocks of a big arena are cut from buffers of a huge page, so that the words stay on few pages
+class WordArena
+{
+public:
+    explicit WordArena(bool usesHugePages = false);
+
+    ArenaWord store(std::string_view word);
+
+    std::string_view view(ArenaWord word) const
+    {
+        const Block& block = blocks[word.position >> BLOCK_BITS];
+        return { block.bytes + (word.position & (BLOCK_SIZE - 1)),
+            word.length == MAX_LENGTH ? block.size : word.length };
+    }
+
+    // takes the blocks of the other arena, the views into them stay valid
+    // returns what to add to the positions of the words of the other arena
+    std::uint64_t adopt(WordArena&& other);
+
+private:
+    static constexpr unsigned BLOCK_BITS    = 16;
+    static constexpr std::size_t BLOCK_SIZE = std::size_t { 1 } << BLOCK_BITS;
+    static constexpr std::size_t MAX_LENGTH = (std::size_t { 1 } << 24) - 1;
+
+    struct Block
+    {
+        char* bytes;
+        std::size_t size;
+    };
+
+    // starts a block for the small words
+    void addBlock();
+
+    bool usesHugePages;
+    // the blocks are cut from the buffers
+    std::vector<PageBuffer> buffers;
+    std::vector<Block> blocks;
+    // what is left of the last buffer, in whole blocks
+    char* freeBlocks           = nullptr;
+    std::size_t freeBlockCount = 0;
+    // the block that the small words are stored in
+    std::size_t freeBlock    = 0;
+    char* freeSpace          = nullptr;
+    std::size_t freeCapacity = 0;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "StringUtilities.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// many words of one buffer, given as offsets and lengths, to be scored with one call
+// the pipeline builds them from the tokenized chunks, the services embedding the engine from their own buffers
+struct WordBatch
+{
+    const char* data = nullptr;
+    std::span<const std::uint32_t> offsets;
+    std::span<const std::uint32_t> lengths;
+
+    std::size_t size() const
+    {
+        return offsets.size();
+    }
+};
+
+namespace word_batch
+{
+    // returned when all the words of the batch are valid UTF-8
+    constexpr std::size_t NO_INVALID_WORD = static_cast<std::size_t>(-1);
+
+    // validates and decodes the words, onCodepoint(word, codepoint) gets the index of the word in the batch
+    // returns the index of the first word holding an invalid sequence, NO_INVALID_WORD if there is none,
+    // the decoding of an invalid word stops at its first invalid sequence
+    template <typename OnCodepoint>
+    std::size_t decode(const WordBatch& batch, OnCodepoint&& onCodepoint)
+    {
+        std::size_t firstInvalidWord = NO_INVALID_WORD;
+        for (std::size_t word = 0; word < batch.size(); ++word) {
+            const std::string_view bytes(batch.data + batch.offsets[word], batch.lengths[word]);
+            const std::size_t invalidPosition = string_utilities::decodeUtf8(
+                bytes, [&onCodepoint, word](char32_t codepoint) { onCodepoint(word, codepoint); });
+            if (invalidPosition != std::string_view::npos) {
+                firstInvalidWord = std::min(firstInvalidWord, word);
+            }
+        }
+        return firstInvalidWord;
+    }
+
+    // writes the points of each word of the batch, the scorer is a ScoringScheme or an AlphabetScorer
+    // the sum stays in a register for the whole word, the table loads of a run of ASCII are independent
+    // returns the index of the first invalid word, NO_INVALID_WORD if there is none
+    template <typename Scorer>
+    std::size_t countPoints(const Scorer& scorer, const WordBatch& batch, std::span<int> points)
+    {
+        std::size_t firstInvalidWord = NO_INVALID_WORD;
+        for (std::size_t word = 0; word < batch.size(); ++word) {
+            const std::string_view bytes(batch.data + batch.offsets[word], batch.lengths[word]);
+            int total                         = 0;
+            const std::size_t invalidPosition = string_utilities::decodeUtf8(
+                bytes, [&scorer, &total](char32_t codepoint) { total += scorer.points(codepoint); });
+            points[word] = total;
+            if (invalidPosition != std::string_view::npos) {
+                firstInvalidWord = std::min(firstInvalidWord, word);
+            }
+        }
+        return firstInvalidWord;
+    }
+} // namespace word_batch
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "HugePages.h"
+#include "StringUtilities.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// the words already kept by the deduplication, in an open addressing table in the manner of the Swiss tables
+// each slot has a control byte holding 7 bits of the hash of its word, the control bytes of a group of 16 slots
+// are compared at once, so a lookup mostly compares one word and never follows a pointer
+// the slots keep the hash of their word, the table grows without hashing the words again
+// the words are never removed, and the set does not own them: the views must outlive it
+class WordSet
+{
+public:
+    // a big table on huge pages takes fewer TLB entries, its probes miss the TLB less often
+    explicit WordSet(bool usesHugePages = false);
+
+    // adds the word unless an equal word is in the set, returns the view in the set and true if the word was added
+    // the caller may replace the view with an equal one that outlives the buffer of the word, until the next insert
+    std::pair<std::string_view*, bool> insert(std::string_view word)
+    {
+        return insert(word, string_utilities::hashWord(word));
+    }
+
+    // the hash must be string_utilities::hashWord(word), computed beforehand
+    std::pair<std::string_view*, bool> insert(std::string_view word, std::uint64_t hash)
+    {
+        const std::uint8_t tag = tagOf(hash);
+        if (wordCount >= maxWordCount) {
+            grow();
+        }
+        std::size_t group = hash & groupMask;
+        for (std::size_t step = 1;; group = (group + step++) & groupMask) {
+            const std::uint8_t* groupControls = controls.data() + group * GROUP_SIZE;
+            for (std::uint32_t matches = match(groupControls, tag); matches != 0; matches &= matches - 1) {
+                Slot& slot = slots[group * GROUP_SIZE + std::countr_zero(matches)];
+                if (slot.hash == hash && slot.word == word) {
+                    return { &slot.word, false };
+                }
+            }
+            // the words are inserted at the first group with an empty slot, so they cannot be further
+            if (const std::uint32_t empties = match(groupControls, EMPTY); empties != 0) {
+                const std::size_t index = group * GROUP_SIZE + std::countr_zero(empties);
+                controls[index]         = tag;
+                slots[index]            = { word, hash };
+                ++wordCount;
+                return { &slots[index].word, true };
+            }
+        }
+    }
+
+    // inserts the words as insert does, a batch at a time: for the whole batch, the control bytes of the first group
+    // of each word are prefetched, then the slot that its insert will read or write, and only then are the words
+    // inserted, so that the cache misses of a batch overlap instead of following one another
+    // onNewWord(i, view) is called for each word added, and may replace the view as after insert
+    template <typename OnNewWord>
+    void insertBatch(
+        std::span<const std::string_view> words, std::span<const std::uint64_t> hashes, OnNewWord&& onNewWord)
+    {
+        for (std::size_t first = 0; first < words.size(); first += BATCH_SIZE) {
+            const std::size_t count = std::min(BATCH_SIZE, words.size() - first);
+            // the table grows before the prefetches rather than in the middle of the batch
+            if (wordCount + count > maxWordCount) {
+                reserve(wordCount + count);
+            }
+            if (slots.size() * sizeof(Slot) >= MIN_PREFETCHED_SIZE) {
+                for (std::size_t i = first; i < first + count; ++i) {
+                    prefetch(controls.data() + (hashes[i] & groupMask) * GROUP_SIZE);
+                }
+                for (std::size_t i = first; i < first + count; ++i) {
+                    if (const Slot* slot = firstProbedSlot(hashes[i]); slot != nullptr) {
+                        prefetch(slot);
+                    }
+                }
+            }
+            for (std::size_t i = first; i < first + count; ++i) {
+                if (const auto [word, isNew] = insert(words[i], hashes[i]); isNew) {
+                    onNewWord(i, *word);
+                }
+            }
+        }
+    }
+
+    std::size_t size() const;
+    // makes room for the words, so that inserting them does not grow the table
+    void reserve(std::size_t count);
+
+private:
+    static constexpr std::size_t GROUP_SIZE = 16;
+    // enough words for their cache misses to overlap, few enough for their lines to stay in the cache
+    static constexpr std::size_t BATCH_SIZE = 32;
+    // a smaller table stays in the cache, where the prefetches only cost
+    static constexpr std::size_t MIN_PREFETCHED_SIZE = 1 << 20;
+    // the tags of the full slots are the 7 high bits of the hash, so they never have the high bit set
+    static constexpr std::uint8_t EMPTY = 0x80;
+
+    struct Slot
+    {
+        std::string_view word;
+        std::uint64_t hash;
+    };
+
+    // one bit per slot of the group whose control byte is byte
+    static std::uint32_t match(const std::uint8_t* groupControls, std::uint8_t byte)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(groupControls));
+        return static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(byte)))));
+#else
+        std::uint32_t matches = 0;
+        for (std::size_t i = 0; i < GROUP_SIZE; ++i) {
+            matches |= static_cast<std::uint32_t>(groupControls[i] == byte) << i;
+        }
+        return matches;
+#endif
+    }
+
+    static std::uint8_t tagOf(std::uint64_t hash)
+    {
+        return static_cast<std::uint8_t>(hash >> 57);
+    }
+
+    static void prefetch(const void* address)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__)
+        __builtin_prefetch(address);
+#endif
+    }
+
+    // the slot of the first group whose tag matches the hash, or else its first empty slot, nullptr if there is none
+    const Slot* firstProbedSlot(std::uint64_t hash) const
+    {
+        const std::size_t groupStart = (hash & groupMask) * GROUP_SIZE;
+        std::uint32_t candidates     = match(controls.data() + groupStart, tagOf(hash));
+        if (candidates == 0) {
+            candidates = match(controls.data() + groupStart, EMPTY);
+        }
+        return candidates == 0 ? nullptr : &slots[groupStart + std::countr_zero(candidates)];
+    }
+
+    // doubles the slots, at least one group
+    void grow();
+    void rehash(std::size_t groupCount);
+
+    HugePageVector<std::uint8_t> controls;
+    HugePageVector<Slot> slots;
+    std::size_t groupMask = 0;
+    std::size_t wordCount = 0;
+    // at most 7 slots in 8 are full, so that the probes stay short
+    std::size_t maxWordCount = 0;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a pool of workers, each with its own deque of tasks
+// a worker runs the newest task of its own deque first, and when it is empty, it steals the oldest task
+// of another worker, so that workers stay busy when tasks have very different costs
+// on a NUMA machine, the workers can be spread over the nodes: a task can be submitted to the workers of a node,
+// and a worker steals from the workers of its own node before the others
+class WorkStealingScheduler
+{
+public:
+    using Task = std::function<void()>;
+
+    static constexpr unsigned ANY_NODE = ~0U;
+
+    // 0 workers selects the number of hardware threads
+    // pinning binds worker i to core i, where the platform allows it
+    // spreading over the nodes gives each node a share of the workers, bound to its cores, or each pinned to one
+    // of them when pinning too
+    explicit WorkStealingScheduler(unsigned workerCount = 0, bool pinWorkers = false, bool spreadOverNodes = false);
+    WorkStealingScheduler(const WorkStealingScheduler&)            = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+    ~WorkStealingScheduler();
+
+    // a task submitted from a worker goes to the deque of this worker, otherwise the deques take turns
+    // a task for a node goes to the workers of the node, node is taken modulo the number of nodes
+    void submit(Task task, unsigned node = ANY_NODE);
+    // runs one queued task on the calling thread, returns false if there was none
+    // a thread waiting for tasks to finish calls it instead of blocking, so that waiting never starves the pool
+    bool runPendingTask();
+    unsigned workerCount() const;
+    // 1 unless the workers are spread over the nodes of a NUMA machine
+    unsigned nodeCount() const;
+    bool isWorkerThread() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void runWorker(unsigned workerIndex);
+    bool tryTakeTask(unsigned firstVictim, Task& task);
+    bool tryPopNewest(unsigned workerIndex, Task& task);
+    bool tryStealOldest(unsigned workerIndex, Task& task);
+    static void pinCurrentThread(const std::vector<unsigned>& cores);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<unsigned> workerNodes;
+    // nodeWorkers[node] are the indices of the workers of the node
+    std::vector<std::vector<unsigned>> nodeWorkers;
+    std::atomic<std::size_t> queuedTasks = 0;
+    std::atomic<unsigned> nextWorker     = 0;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+    std::vector<std::jthread> threads;
+};
+
+// counts the tasks submitted through it, so that they can be waited for together
+// the first exception thrown by a task is rethrown by wait
+class TaskGroup
+{
+public:
+    explicit TaskGroup(WorkStealingScheduler& scheduler);
+    TaskGroup(const TaskGroup&)            = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    ~TaskGroup();
+
+    void run(WorkStealingScheduler::Task task, unsigned node = WorkStealingScheduler::ANY_NODE);
+    void wait();
+
+private:
+    WorkStealingScheduler& scheduler;
+    std::atomic<std::size_t> pendingTasks = 0;
+    std::mutex mutex;
+    std::exception_ptr firstError;
+};
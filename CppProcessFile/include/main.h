@@ -1,5 +1,12 @@
-#pragma once
-
-#include <string>
-
-std::string getFilePathFromArgv(int argc, char* argv[]);
+#pragma once
+
+#include "ProcessingOptions.h"
+
+#include <string>
+#include <vector>
+
+// the command line is: [--option=value ...] inputPath [inputPath ...]
+std::vector<std::string> getFilePathsFromArgv(int argc, char* argv[]);
+std::string getFilePathFromArgument(const std::string& filePath);
+ProcessingOptions getProcessingOptionsFromArgv(int argc, char* argv[]);
+void applyOption(const std::string& name, const std::string& value, ProcessingOptions& options);
@@ -0,0 +1,96 @@
+#include "AsyncIo.h"
+
+#include <utility>
+
+using namespace std;
+
+BlockingCallPool::BlockingCallPool(unsigned threadCount)
+{
+    for (unsigned i = 0; i < max(threadCount, 1U); ++i) {
+        threads.emplace_back([this]() { runThread(); });
+    }
+}
+
+BlockingCallPool::~BlockingCallPool()
+{
+    {
+        lock_guard lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    threads.clear();
+}
+
+void BlockingCallPool::post(function<void()> call)
+{
+    // notifying under the lock keeps the pool alive until the notification is done, the destructor takes the lock
+    lock_guard lock(mutex);
+    calls.push_back(std::move(call));
+    wakeUp.notify_one();
+}
+
+void BlockingCallPool::runThread()
+{
+    while (true) {
+        function<void()> call;
+        {
+            unique_lock lock(mutex);
+            wakeUp.wait(lock, [this]() { return stopping || !calls.empty(); });
+            if (calls.empty()) {
+                return;
+            }
+            call = std::move(calls.front());
+            calls.pop_front();
+        }
+        call();
+    }
+}
+
+ReadAwaitable::ReadAwaitable(
+    ByteSource& source, span<char> destination, BlockingCallPool& pool, WorkStealingScheduler& scheduler) :
+    source(source),
+    destination(destination),
+    pool(pool),
+    scheduler(scheduler)
+{
+}
+
+bool ReadAwaitable::await_ready() const
+{
+    return source.isReadReady();
+}
+
+void ReadAwaitable::await_suspend(coroutine_handle<> awaiting)
+{
+    suspended = true;
+    pool.post([this, awaiting]() {
+        readCount = source.read(destination.data(), destination.size());
+        scheduler.submit([awaiting]() { awaiting.resume(); });
+    });
+}
+
+Expected<size_t> ReadAwaitable::await_resume()
+{
+    if (!suspended) {
+        return source.read(destination.data(), destination.size());
+    }
+    return readCount;
+}
+
+YieldAwaitable::YieldAwaitable(WorkStealingScheduler& scheduler) : scheduler(scheduler)
+{
+}
+
+bool YieldAwaitable::await_ready() const noexcept
+{
+    return false;
+}
+
+void YieldAwaitable::await_suspend(coroutine_handle<> awaiting) const
+{
+    scheduler.submit([awaiting]() { awaiting.resume(); });
+}
+
+void YieldAwaitable::await_resume() const noexcept
+{
+}
@@ -0,0 +1,500 @@
+#include "ByteSource.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CPP_PROCESS_FILE_HAS_POSIX_IO
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CPP_PROCESS_FILE_HAS_IO_URING
+#include <atomic>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    Error openError()
+    {
+        return { ErrorCode::FileOpen, "Error - Impossible to open the input file." };
+    }
+
+    Error readError()
+    {
+        return { ErrorCode::FileRead, "Error - Impossible to read the input file." };
+    }
+
+    class StreamByteSource : public ByteSource
+    {
+    public:
+        static Expected<unique_ptr<ByteSource>> open(const string& path)
+        {
+            auto source = make_unique<StreamByteSource>();
+            source->inputFile.open(path, ios::in | ios::binary);
+            if (!source->inputFile.is_open()) {
+                return openError();
+            }
+            return source;
+        }
+
+        Expected<size_t> read(char* destination, size_t capacity) override
+        {
+            inputFile.read(destination, static_cast<streamsize>(capacity));
+            if (inputFile.bad()) {
+                return readError();
+            }
+            return static_cast<size_t>(inputFile.gcount());
+        }
+
+    private:
+        ifstream inputFile;
+    };
+
+#ifdef CPP_PROCESS_FILE_HAS_POSIX_IO
+    class FileDescriptor
+    {
+    public:
+        FileDescriptor() = default;
+        FileDescriptor(const FileDescriptor&)            = delete;
+        FileDescriptor& operator=(const FileDescriptor&) = delete;
+        ~FileDescriptor()
+        {
+            if (descriptor >= 0) {
+                ::close(descriptor);
+            }
+        }
+
+        Expected<void> open(const string& path)
+        {
+            descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0) {
+                return openError();
+            }
+            return {};
+        }
+
+        int get() const
+        {
+            return descriptor;
+        }
+
+        Expected<size_t> fileSize() const
+        {
+            struct stat status = {};
+            if (fstat(descriptor, &status) != 0) {
+                return readError();
+            }
+            return static_cast<size_t>(status.st_size);
+        }
+
+    private:
+        int descriptor = -1;
+    };
+
+    // reads at an explicit offset until capacity bytes or the end of the file, retrying on interruption
+    Expected<size_t> preadFully(int descriptor, char* destination, size_t capacity, size_t offset)
+    {
+        size_t total = 0;
+        while (total < capacity) {
+            const ssize_t readCount = ::pread(descriptor, destination + total, capacity - total,
+                static_cast<off_t>(offset + total));
+            if (readCount < 0 && errno == EINTR) {
+                continue;
+            }
+            if (readCount < 0) {
+                return readError();
+            }
+            if (readCount == 0) {
+                break;
+            }
+            total += static_cast<size_t>(readCount);
+        }
+        return total;
+    }
+
+    class PreadByteSource : public ByteSource
+    {
+    public:
+        static Expected<unique_ptr<ByteSource>> open(const string& path)
+        {
+            auto source = make_unique<PreadByteSource>();
+            if (Expected<void> opened = source->file.open(path); !opened) {
+                return opened.error();
+            }
+#ifdef POSIX_FADV_SEQUENTIAL
+            posix_fadvise(source->file.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+            return source;
+        }
+
+        Expected<size_t> read(char* destination, size_t capacity) override
+        {
+            const Expected<size_t> readCount = preadFully(file.get(), destination, capacity, offset);
+            if (readCount) {
+                offset += *readCount;
+            }
+            return readCount;
+        }
+
+    private:
+        FileDescriptor file;
+        size_t offset = 0;
+    };
+
+    class MmapByteSource : public ByteSource
+    {
+    public:
+        static Expected<unique_ptr<ByteSource>> open(const string& path)
+        {
+            auto source = make_unique<MmapByteSource>();
+            if (Expected<void> opened = source->file.open(path); !opened) {
+                return opened.error();
+            }
+            const Expected<size_t> size = source->file.fileSize();
+            if (!size) {
+                return size.error();
+            }
+            source->size = *size;
+            if (source->size == 0) {
+                return source;
+            }
+            void* address = mmap(nullptr, source->size, PROT_READ, MAP_PRIVATE, source->file.get(), 0);
+            if (address == MAP_FAILED) {
+                return Error { ErrorCode::FileRead, "Error - Impossible to map the input file." };
+            }
+            source->mapping = static_cast<const char*>(address);
+            madvise(address, source->size, MADV_SEQUENTIAL);
+            return source;
+        }
+
+        MmapByteSource() = default;
+        MmapByteSource(const MmapByteSource&)            = delete;
+        MmapByteSource& operator=(const MmapByteSource&) = delete;
+        ~MmapByteSource() override
+        {
+            if (mapping != nullptr) {
+                munmap(const_cast<char*>(mapping), size);
+            }
+        }
+
+        bool isReadReady() const override
+        {
+            return true;
+        }
+
+        Expected<size_t> read(char* destination, size_t capacity) override
+        {
+            const size_t readCount = min(capacity, size - offset);
+            memcpy(destination, mapping + offset, readCount);
+            offset += readCount;
+            return readCount;
+        }
+
+    private:
+        FileDescriptor file;
+        size_t size         = 0;
+        const char* mapping = nullptr;
+        size_t offset       = 0;
+    };
+#endif
+
+#ifdef CPP_PROCESS_FILE_HAS_IO_URING
+    // keeps QUEUE_DEPTH fixed-size reads in flight into buffers registered with the kernel
+    // the blocks are submitted in file order and handed out in file order, whatever the completion order
+    class UringByteSource : public ByteSource
+    {
+    public:
+        // returns nullptr when io_uring or buffer registration is not available
+        static Expected<unique_ptr<UringByteSource>> open(const string& path)
+        {
+            auto source = unique_ptr<UringByteSource>(new UringByteSource());
+            if (Expected<void> opened = source->file.open(path); !opened) {
+                return opened.error();
+            }
+            const Expected<size_t> fileSize = source->file.fileSize();
+            if (!fileSize) {
+                return fileSize.error();
+            }
+            source->fileSize = *fileSize;
+            if (!source->setUpRing()) {
+                return unique_ptr<UringByteSource>();
+            }
+            for (unsigned i = 0; i < QUEUE_DEPTH; ++i) {
+                if (Expected<void> submitted = source->submit(i); !submitted) {
+                    return submitted.error();
+                }
+            }
+            return source;
+        }
+
+        UringByteSource(const UringByteSource&)            = delete;
+        UringByteSource& operator=(const UringByteSource&) = delete;
+        ~UringByteSource() override
+        {
+            // close() does not wait for the reads in flight, the kernel cancels and reaps them later, and could still
+            // write into the buffers once freed, so the reads are reaped first
+            if (ringDescriptor >= 0) {
+                if (!drainCompletions()) {
+                    // the ring cannot be waited on, the buffers are left to the kernel rather than to the allocator
+                    static_cast<void>(new vector<char>(std::move(buffers)));
+                }
+                ::close(ringDescriptor);
+            }
+            if (submissionEntries != nullptr) {
+                munmap(submissionEntries, submissionEntriesSize);
+            }
+            if (completionRing != nullptr && completionRing != submissionRing) {
+                munmap(completionRing, completionRingSize);
+            }
+            if (submissionRing != nullptr) {
+                munmap(submissionRing, submissionRingSize);
+            }
+        }
+
+        bool isReadReady() const override
+        {
+            return blocks[currentBlock].state != BlockState::InFlight;
+        }
+
+        Expected<size_t> read(char* destination, size_t capacity) override
+        {
+            Block& block = blocks[currentBlock];
+            while (block.state == BlockState::InFlight) {
+                if (Expected<void> completed = waitForCompletions(); !completed) {
+                    return completed.error();
+                }
+            }
+            if (block.state == BlockState::Empty) {
+                return 0;
+            }
+            const size_t readCount = min(capacity, block.size - block.consumed);
+            memcpy(destination, block.data + block.consumed, readCount);
+            block.consumed += readCount;
+            if (block.consumed == block.size) {
+                if (Expected<void> submitted = submit(currentBlock); !submitted) {
+                    return submitted.error();
+                }
+                currentBlock = (currentBlock + 1) % QUEUE_DEPTH;
+            }
+            return readCount;
+        }
+
+    private:
+        static constexpr unsigned QUEUE_DEPTH   = 8;
+        static constexpr size_t READ_BLOCK_SIZE = 256 * 1024;
+
+        enum class BlockState
+        {
+            Empty,
+            InFlight,
+            Ready
+        };
+
+        struct Block
+        {
+            char* data       = nullptr;
+            size_t offset    = 0;
+            size_t size      = 0;
+            size_t consumed  = 0;
+            BlockState state = BlockState::Empty;
+        };
+
+        UringByteSource() : buffers(QUEUE_DEPTH * READ_BLOCK_SIZE)
+        {
+        }
+
+        bool setUpRing()
+        {
+            io_uring_params parameters = {};
+            ringDescriptor = static_cast<int>(syscall(__NR_io_uring_setup, QUEUE_DEPTH, &parameters));
+            if (ringDescriptor < 0) {
+                return false;
+            }
+            submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+            completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+            const bool singleMapping = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMapping) {
+                submissionRingSize = completionRingSize = max(submissionRingSize, completionRingSize);
+            }
+            submissionRing = mapRing(submissionRingSize, IORING_OFF_SQ_RING);
+            if (submissionRing == nullptr) {
+                return false;
+            }
+            completionRing = singleMapping ? submissionRing : mapRing(completionRingSize, IORING_OFF_CQ_RING);
+            submissionEntriesSize = parameters.sq_entries * sizeof(io_uring_sqe);
+            submissionEntries     = reinterpret_cast<io_uring_sqe*>(mapRing(submissionEntriesSize, IORING_OFF_SQES));
+            if (completionRing == nullptr || submissionEntries == nullptr) {
+                return false;
+            }
+            submissionTail  = reinterpret_cast<unsigned*>(submissionRing + parameters.sq_off.tail);
+            submissionMask  = *reinterpret_cast<unsigned*>(submissionRing + parameters.sq_off.ring_mask);
+            submissionArray = reinterpret_cast<unsigned*>(submissionRing + parameters.sq_off.array);
+            completionHead  = reinterpret_cast<unsigned*>(completionRing + parameters.cq_off.head);
+            completionTail  = reinterpret_cast<unsigned*>(completionRing + parameters.cq_off.tail);
+            completionMask  = *reinterpret_cast<unsigned*>(completionRing + parameters.cq_off.ring_mask);
+            completions     = reinterpret_cast<io_uring_cqe*>(completionRing + parameters.cq_off.cqes);
+
+            iovec registered[QUEUE_DEPTH];
+            for (unsigned i = 0; i < QUEUE_DEPTH; ++i) {
+                blocks[i].data = buffers.data() + i * READ_BLOCK_SIZE;
+                registered[i]  = { blocks[i].data, READ_BLOCK_SIZE };
+            }
+            return syscall(__NR_io_uring_register, ringDescriptor, IORING_REGISTER_BUFFERS, registered, QUEUE_DEPTH) ==
+                0;
+        }
+
+        char* mapRing(size_t size, off_t offset) const
+        {
+            void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor,
+                offset);
+            return address == MAP_FAILED ? nullptr : static_cast<char*>(address);
+        }
+
+        // queues the read of the next block of the file into the buffer of the block, if any is left
+        Expected<void> submit(unsigned blockIndex)
+        {
+            Block& block = blocks[blockIndex];
+            block        = { block.data, nextOffset, 0, 0, BlockState::Empty };
+            if (nextOffset >= fileSize) {
+                return {};
+            }
+            block.size = min(READ_BLOCK_SIZE, fileSize - nextOffset);
+            nextOffset += block.size;
+            block.state = BlockState::InFlight;
+
+            const unsigned tail   = *submissionTail;
+            const unsigned slot   = tail & submissionMask;
+            io_uring_sqe& entry   = submissionEntries[slot];
+            entry                 = {};
+            entry.opcode          = IORING_OP_READ_FIXED;
+            entry.fd              = file.get();
+            entry.addr            = reinterpret_cast<uint64_t>(block.data);
+            entry.len             = static_cast<uint32_t>(block.size);
+            entry.off             = block.offset;
+            entry.buf_index       = static_cast<uint16_t>(blockIndex);
+            entry.user_data       = blockIndex;
+            submissionArray[slot] = slot;
+            atomic_ref(*submissionTail).store(tail + 1, memory_order_release);
+            long submitted = 0;
+            do {
+                submitted = syscall(__NR_io_uring_enter, ringDescriptor, 1, 0, 0, nullptr, 0);
+            } while (submitted < 0 && errno == EINTR);
+            if (submitted != 1) {
+                // the kernel did not take the entry, it is withdrawn so that no completion is waited for it
+                atomic_ref(*submissionTail).store(tail, memory_order_release);
+                block.state = BlockState::Empty;
+                return readError();
+            }
+            return {};
+        }
+
+        Expected<void> waitForCompletions()
+        {
+            if (syscall(__NR_io_uring_enter, ringDescriptor, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                errno != EINTR) {
+                return readError();
+            }
+            unsigned head       = *completionHead;
+            const unsigned tail = atomic_ref(*completionTail).load(memory_order_acquire);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& completion = completions[head & completionMask];
+                Block& block                   = blocks[completion.user_data];
+                if (completion.res < 0) {
+                    return readError();
+                }
+                const size_t readCount = static_cast<size_t>(completion.res);
+                if (readCount < block.size) {
+                    // a short read, the rest of the block is read synchronously
+                    const Expected<size_t> restCount = preadFully(
+                        file.get(), block.data + readCount, block.size - readCount, block.offset + readCount);
+                    if (!restCount) {
+                        return restCount.error();
+                    }
+                    block.size = readCount + *restCount;
+                }
+                block.state = BlockState::Ready;
+            }
+            atomic_ref(*completionHead).store(head, memory_order_release);
+            return {};
+        }
+
+        // waits until no block is in flight, a read that completes is dropped, its block will not be handed out
+        // returns false when the ring cannot be waited on
+        bool drainCompletions()
+        {
+            const auto isInFlight = [](const Block& block) { return block.state == BlockState::InFlight; };
+            while (any_of(begin(blocks), end(blocks), isInFlight)) {
+                if (syscall(__NR_io_uring_enter, ringDescriptor, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                    errno != EINTR) {
+                    return false;
+                }
+                unsigned head       = *completionHead;
+                const unsigned tail = atomic_ref(*completionTail).load(memory_order_acquire);
+                for (; head != tail; ++head) {
+                    blocks[completions[head & completionMask].user_data].state = BlockState::Empty;
+                }
+                atomic_ref(*completionHead).store(head, memory_order_release);
+            }
+            return true;
+        }
+
+        FileDescriptor file;
+        size_t fileSize = 0;
+        vector<char> buffers;
+        Block blocks[QUEUE_DEPTH];
+        unsigned currentBlock = 0;
+        size_t nextOffset     = 0;
+
+        int ringDescriptor              = -1;
+        char* submissionRing            = nullptr;
+        char* completionRing            = nullptr;
+        io_uring_sqe* submissionEntries = nullptr;
+        size_t submissionRingSize       = 0;
+        size_t completionRingSize       = 0;
+        size_t submissionEntriesSize    = 0;
+        unsigned* submissionTail        = nullptr;
+        unsigned* submissionArray       = nullptr;
+        unsigned submissionMask         = 0;
+        unsigned* completionHead        = nullptr;
+        unsigned* completionTail        = nullptr;
+        unsigned completionMask         = 0;
+        io_uring_cqe* completions       = nullptr;
+    };
+#endif
+} // namespace
+
+Expected<unique_ptr<ByteSource>> openByteSource(const string& path, IoBackend backend)
+{
+#ifdef CPP_PROCESS_FILE_HAS_IO_URING
+    if (backend == IoBackend::Uring) {
+        Expected<unique_ptr<UringByteSource>> source = UringByteSource::open(path);
+        if (!source) {
+            return source.error();
+        }
+        if (*source) {
+            return std::move(*source);
+        }
+    }
+#endif
+#ifdef CPP_PROCESS_FILE_HAS_POSIX_IO
+    if (backend == IoBackend::Uring || backend == IoBackend::Pread) {
+        return PreadByteSource::open(path);
+    }
+    if (backend == IoBackend::Mmap) {
+        return MmapByteSource::open(path);
+    }
+#endif
+    return StreamByteSource::open(path);
+}
@@ -0,0 +1,96 @@
+#include "CaseFolding.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    // the letters up to U+017F are encoded on one byte, or on two bytes with a lead byte up to 0xC5
+    constexpr char32_t TABLE_SIZE = 0x180;
+
+    // the lowercase of each code point below TABLE_SIZE
+    constexpr array<char16_t, TABLE_SIZE> makeLowercase()
+    {
+        array<char16_t, TABLE_SIZE> lowercase {};
+        for (char32_t codepoint = 0; codepoint < TABLE_SIZE; ++codepoint) {
+            lowercase[codepoint] = static_cast<char16_t>(codepoint);
+        }
+        const auto isUppercase = [](char32_t codepoint) {
+            if ((codepoint >= U'A' && codepoint <= U'Z') || (codepoint >= 0xC0 && codepoint <= 0xDE)) {
+                return codepoint != 0xD7;
+            }
+            // Latin Extended-A alternates uppercase and lowercase, with a shift where U+0138 and U+0149 stand alone
+            // U+0130 becomes i, which is one byte shorter
+            if ((codepoint >= 0x100 && codepoint <= 0x12F) || (codepoint >= 0x132 && codepoint <= 0x137) ||
+                (codepoint >= 0x14A && codepoint <= 0x177)) {
+                return codepoint % 2 == 0;
+            }
+            return ((codepoint >= 0x139 && codepoint <= 0x148) || (codepoint >= 0x179 && codepoint <= 0x17E)) &&
+                   codepoint % 2 == 1;
+        };
+        for (char32_t codepoint = 0; codepoint < TABLE_SIZE; ++codepoint) {
+            if (isUppercase(codepoint)) {
+                lowercase[codepoint] = static_cast<char16_t>(codepoint < 0x100 ? codepoint + 0x20 : codepoint + 1);
+            }
+        }
+        lowercase[0x178] = 0xFF;
+        return lowercase;
+    }
+
+    constexpr array<char16_t, TABLE_SIZE> LOWERCASE = makeLowercase();
+
+    // adds 0x20 to the bytes from A to Z, the other bytes, non-ASCII ones included, are left as they are
+    uint64_t asciiToLowercase(uint64_t bytes)
+    {
+        constexpr uint64_t ONES      = 0x0101010101010101;
+        constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+        // with the high bits clear no addition carries into the next byte
+        const uint64_t lowBits     = bytes & ~HIGH_BITS;
+        const uint64_t fromA       = lowBits + (0x80 - 'A') * ONES;
+        const uint64_t afterZ      = lowBits + (0x7F - 'Z') * ONES;
+        const uint64_t isUppercase = ~bytes & (fromA ^ afterZ) & HIGH_BITS;
+        return bytes | (isUppercase >> 2);
+    }
+} // namespace
+
+// runs of ASCII are handled 8 bytes at a time, the two-byte letters go through the table
+void case_folding::toLowercase(span<char> bytes)
+{
+    constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+    size_t position              = 0;
+    while (position < bytes.size()) {
+        if (bytes.size() - position >= sizeof(uint64_t)) {
+            uint64_t block = 0;
+            memcpy(&block, bytes.data() + position, sizeof(block));
+            if ((block & HIGH_BITS) == 0) {
+                block = asciiToLowercase(block);
+                memcpy(bytes.data() + position, &block, sizeof(block));
+                position += sizeof(block);
+                continue;
+            }
+        }
+        const auto lead = static_cast<unsigned char>(bytes[position]);
+        if (lead < 0x80) {
+            if (lead >= 'A' && lead <= 'Z') {
+                bytes[position] = static_cast<char>(lead + 0x20);
+            }
+            ++position;
+            continue;
+        }
+        const bool isTwoBytes = lead >= 0xC3 && lead <= 0xC5 && bytes.size() - position >= 2 &&
+                                (static_cast<unsigned char>(bytes[position + 1]) & 0xC0) == 0x80;
+        if (isTwoBytes) {
+            const char32_t codepoint = ((lead & 0x1F) << 6) | (static_cast<unsigned char>(bytes[position + 1]) & 0x3F);
+            const char32_t lowercase = LOWERCASE[codepoint];
+            bytes[position]          = static_cast<char>(0xC0 | (lowercase >> 6));
+            bytes[position + 1]      = static_cast<char>(0x80 | (lowercase & 0x3F));
+            position += 2;
+            continue;
+        }
+        ++position;
+    }
+}
@@ -0,0 +1,55 @@
+#include "ChunkMemory.h"
+
+using namespace std;
+
+ChunkMemory::ChunkMemory(pmr::memory_resource* upstream) : overflow(upstream)
+{
+    monotonic.emplace(&overflow);
+}
+
+ChunkMemory::~ChunkMemory()
+{
+    monotonic.reset();
+    if (buffer != nullptr) {
+        overflow.upstream->deallocate(buffer, bufferSize, alignof(max_align_t));
+    }
+}
+
+void ChunkMemory::release()
+{
+    monotonic->release();
+    if (overflow.takenSize == 0) {
+        return;
+    }
+    // the chunk did not fit in the buffer, the next ones get a buffer as large as all that it took
+    const size_t size = bufferSize + overflow.takenSize;
+    monotonic.reset();
+    if (buffer != nullptr) {
+        overflow.upstream->deallocate(buffer, bufferSize, alignof(max_align_t));
+    }
+    buffer             = static_cast<byte*>(overflow.upstream->allocate(size, alignof(max_align_t)));
+    bufferSize         = size;
+    overflow.takenSize = 0;
+    monotonic.emplace(buffer, bufferSize, &overflow);
+}
+
+ChunkMemory::OverflowCounter::OverflowCounter(pmr::memory_resource* upstream) : upstream(upstream)
+{
+}
+
+void* ChunkMemory::OverflowCounter::do_allocate(size_t size, size_t alignment)
+{
+    void* memory = upstream->allocate(size, alignment);
+    takenSize += size;
+    return memory;
+}
+
+void ChunkMemory::OverflowCounter::do_deallocate(void* memory, size_t size, size_t alignment)
+{
+    upstream->deallocate(memory, size, alignment);
+}
+
+bool ChunkMemory::OverflowCounter::do_is_equal(const pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
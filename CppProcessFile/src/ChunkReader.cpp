@@ -0,0 +1,83 @@
+#include "ChunkReader.h"
+#include "StringUtilities.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ChunkReader::ChunkReader(size_t chunkSize, bool cutsAtLineEnds) :
+    chunkSize(max<size_t>(chunkSize, 1)),
+    cutsAtLineEnds(cutsAtLineEnds)
+{
+}
+
+void ChunkReader::begin(Chunk& chunk)
+{
+    chunk.releaseMemory();
+    if (chunk.buffer.size() < carry.size() + chunkSize) {
+        chunk.buffer.resize(carry.size() + chunkSize);
+    }
+    ranges::copy(carry, chunk.buffer.begin());
+    chunk.size = carry.size();
+    roundStart = carry.size();
+    carry.clear();
+}
+
+span<char> ChunkReader::nextRead(Chunk& chunk) const
+{
+    return { chunk.buffer.data() + chunk.size, roundStart + chunkSize - chunk.size };
+}
+
+bool ChunkReader::commit(Chunk& chunk, size_t readCount)
+{
+    if (readCount == 0) {
+        endOfInput = true;
+        return finish(chunk, chunk.size);
+    }
+    chunk.size += readCount;
+    if (chunk.size - roundStart < chunkSize) {
+        return false;
+    }
+    // the carried bytes hold no whitespace, or no line feed, so only the bytes of this round are scanned
+    const char* const data       = chunk.buffer.data();
+    const char* const roundBegin = data + roundStart;
+    const char* cut              = data + chunk.size;
+    if (cutsAtLineEnds) {
+        while (cut != roundBegin && cut[-1] != '\n') {
+            --cut;
+        }
+    }
+    if (!cutsAtLineEnds || cut == roundBegin) {
+        cut = data + chunk.size;
+        while (cut != roundBegin && !string_utilities::isWhitespace(cut[-1])) {
+            --cut;
+        }
+    }
+    if (cut != roundBegin) {
+        carry.assign(cut, data + chunk.size);
+        return finish(chunk, static_cast<size_t>(cut - data));
+    }
+    // a word longer than the chunk, the buffer grows until the word ends
+    roundStart = chunk.size;
+    chunk.buffer.resize(chunk.size + chunkSize);
+    return false;
+}
+
+bool ChunkReader::isEndOfInput() const
+{
+    return endOfInput;
+}
+
+size_t ChunkReader::chunkCount() const
+{
+    return sequence;
+}
+
+bool ChunkReader::finish(Chunk& chunk, size_t size)
+{
+    chunk.size        = size;
+    chunk.sequence    = sequence++;
+    chunk.inputOffset = inputOffset;
+    inputOffset += size;
+    return true;
+}
@@ -1,229 +1,697 @@
-
-#include "FileProcessor.h"
-#include "BoostUtilities.h"
-#include "CustomExceptions.h"
-#include "StringUtilities.h"
-
-#include <cstdint>
-#include <fstream>
-#include <iostream>
-#include <iterator>
-#include <ranges>
-#include <regex>
-#include <sstream>
-#include <string>
-#include <string_view>
-#include <unordered_map>
-#include <unordered_set>
-#include <vector>
-
-using namespace std;
-
-namespace
-{
-    constexpr int GIGANTIC_LINE_SIZE = 10000;
-
-    // we store bytes in UTF-8
-    const unordered_map<u8string_view, int> mapLetterToPoints = { { u8"A", 32 },
-        { u8"B", 36 },
-        { u8"C", 33 },
-        { u8"D", 40 },
-        { u8"E", 41 },
-        { u8"F", 47 },
-        { u8"G", 31 },
-        { u8"H", 27 },
-        { u8"I", 49 },
-        { u8"J", 28 },
-        { u8"K", 30 },
-        { u8"L", 42 },
-        { u8"M", 29 },
-        { u8"N", 38 },
-        { u8"O", 51 },
-        { u8"P", 43 },
-        { u8"Q", 45 },
-        { u8"R", 39 },
-        { u8"S", 35 },
-        { u8"T", 52 },
-        { u8"U", 37 },
-        { u8"V", 46 },
-        { u8"W", 34 },
-        { u8"X", 48 },
-        { u8"Y", 44 },
-        { u8"Z", 50 },
-        { u8"", 60 },
-        { u8"", 61 },
-        { u8"", 62 },
-        { u8"", 63 },
-        { u8"", 64 },
-        { u8"", 65 },
-        { u8"", 66 },
-        { u8"", 67 },
-        { u8"", 68 },
-        { u8"", 69 },
-        { u8"", 70 },
-        { u8"", 71 },
-        { u8"", 72 },
-        { u8"a", 1 },
-        { u8"b", 4 },
-        { u8"c", 5 },
-        { u8"d", 8 },
-        { u8"e", 10 },
-        { u8"f", 11 },
-        { u8"g", 13 },
-        { u8"h", 16 },
-        { u8"i", 18 },
-        { u8"j", 19 },
-        { u8"k", 21 },
-        { u8"l", 21 },
-        { u8"m", 23 },
-        { u8"n", 2 },
-        { u8"o", 3 },
-        { u8"p", 6 },
-        { u8"q", 7 },
-        { u8"r", 9 },
-        { u8"s", 12 },
-        { u8"t", 14 },
-        { u8"u", 15 },
-        { u8"v", 17 },
-        { u8"w", 20 },
-        { u8"x", 24 },
-        { u8"y", 25 },
-        { u8"z", 26 } };
-} // namespace
-
-void FileProcessor::process(const string& inputPath, const string& outputPath) const
-{
-    vector<pair<string, int>> pairingUniqueWordsToPoints = createPairingUniqueWordsToPoints(inputPath);
-    createSortedOutputFile(outputPath, pairingUniqueWordsToPoints);
-}
-
-vector<pair<string, int>> FileProcessor::createPairingUniqueWordsToPoints(const string& inputPath) const
-{
-    fstream inputFile;
-    string lineBuffer;
-    // reserving avoids heap allocation and speeds up
-    // if a line is bigger, we still support it with re-allocation
-    lineBuffer.reserve(GIGANTIC_LINE_SIZE);
-
-    inputFile.open(inputPath, ios::in);
-    if (!inputFile.is_open()) {
-        throw FileOpenException("Error - Impossible to open the input file.");
-    }
-    // failbit is set for end of file so we ignore it
-    inputFile.exceptions(std::ifstream::badbit);
-
-    try {
-        vector<pair<string, int>> pairingUniqueWordsToPoints;
-        std::unordered_set<string_view> hashSetProcessedWords;
-        while (getline(inputFile, lineBuffer)) {
-            regex reg("[',]");
-            // here we cannot replace the multi byte apostrophe, but we do it in splitWordOnMultiByteApostrophe
-            while (regex_search(lineBuffer, reg)) {
-                lineBuffer = std::regex_replace(lineBuffer, reg, "");
-            }
-            stringstream ss(lineBuffer);
-            string word;
-            while (ss >> word) {
-                std::vector<std::string> splitWords;
-                // this is to split the word into multiple words on the multi-byte apostrophe
-                if (splitWordOnMultiByteApostrophe(word, splitWords)) {
-                    std::ranges::for_each(splitWords,
-                        [this, &hashSetProcessedWords, &pairingUniqueWordsToPoints](std::string& newWord) {
-                            processWordWithoutDuplicates(
-                                newWord, hashSetProcessedWords, pairingUniqueWordsToPoints);
-                        });
-                } else {
-                    processWordWithoutDuplicates(word, hashSetProcessedWords, pairingUniqueWordsToPoints);
-                }
-            }
-        }
-        return pairingUniqueWordsToPoints;
-    } catch (std::ifstream::failure& e) {
-        std::cerr << "Exception happened: " << e.what() << "\n"
-                  << "Error bits are: "
-                  << "\nfailbit: " << inputFile.fail() << "\neofbit: " << inputFile.eof()
-                  << "\nbadbit: " << inputFile.bad() << std::endl;
-        throw FileReadException();
-    }
-}
-
-void FileProcessor::processWordWithoutDuplicates(const string& word,
-    std::unordered_set<string_view>& hashSetProcessedWords,
-    vector<pair<string, int>>& pairingUniqueWordsToPoints) const
-{
-    // there must be no duplicates
-    if (hashSetProcessedWords.contains(word)) {
-        return;
-    }
-    processWordForPairingToPoints(word, pairingUniqueWordsToPoints);
-    hashSetProcessedWords.insert(word);
-}
-
-void FileProcessor::validateEncoding(const string& word) const
-{
-    // for now, we only support UTF8 input, we discard latin1
-    if (auto pos = string_utilities::find_first_not_utf8(word); pos < word.length()) {
-        throw NonUtf8CharactersFoundException();
-    }
-}
-
-void FileProcessor::createSortedOutputFile(
-    const string& outputPath, vector<pair<string, int>>& pairingUniqueWordsToPoints) const
-{
-    fstream outputFile;
-    outputFile.open(outputPath, ios::trunc | ios::out);
-    if (!outputFile.is_open()) {
-        throw FileOpenException("Error - Impossible to open the output file.");
-    }
-    ranges::sort(
-        pairingUniqueWordsToPoints, [](const std::pair<string, int>& left, const std::pair<string, int>& right) {
-            return left.second < right.second;
-        });
-    std::ranges::for_each(pairingUniqueWordsToPoints, [&outputFile](const std::pair<string, int>& element) {
-        outputFile << element.first << ", " << element.second << endl;
-    });
-}
-
-void FileProcessor::processWordForPairingToPoints(
-    const string& word, vector<pair<std::string, int>>& pairingUniqueWordsToPoints) const
-{
-    validateEncoding(word);
-    int points = countPoints(word);
-    pairingUniqueWordsToPoints.emplace_back(pair(word, points));
-}
-
-// the apostrophe, U2019 has code 8217
-// https://unicode.scarfboy.com/?s=U%2b2019
-bool FileProcessor::splitWordOnMultiByteApostrophe(const std::string& word, vector<std::string>& splitWords) const
-{
-    if (string trimmedWord; boost_utilities::replaceMultiByteApostropheWithBlank(word, trimmedWord)) {
-        stringstream check1(trimmedWord);
-        string buffer1;
-        // Tokenizing with regard to space ' '
-        while (getline(check1, buffer1, ' ')) {
-            splitWords.push_back(buffer1);
-        }
-        return true;
-    }
-    return false;
-}
-
-// "" takes 2 bytes in UTF-8, so we need to iterate on multi-byte characters
-int FileProcessor::countPoints(const std::string& word) const
-{
-    int total                                 = 0;
-    std::function<void(uint32_t&)> funIterate = [&total](uint32_t& codePoint) {
-        // tested to work on trema u code 252
-        // char32_t codePoint2 = (char32_t)252;
-        std::u8string key = reinterpret_cast<const char8_t*>(boost_utilities::codepoint_to_utf8(codePoint).c_str());
-        try {
-            int points = mapLetterToPoints.at(key);
-            total += points;
-        } catch (out_of_range&) {
-            // any other character counts as 0
-            std::ignore = 0;
-        }
-    };
-    boost_utilities::iterateOnMultiByteCharacters(word, funIterate);
-    return total;
-}
+﻿
+#include "FileProcessor.h"
+#include "AlphabetScorer.h"
+#include "AsyncIo.h"
+#include "CaseFolding.h"
+#include "ChunkReader.h"
+#include "NfcNormalizer.h"
+#include "PartitionedDeduplicator.h"
+#include "ProcessingPipeline.h"
+#include "ScoringScheme.h"
+#include "StringUtilities.h"
+#include "Tokenizer.h"
+#include "WordBatch.h"
+#include "WorkStealingScheduler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <numeric>
+#include <ranges>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // "texte.count.txt" and "french" give "texte.count.french.txt"
+    string insertBeforeExtension(const string& path, const string& name)
+    {
+        size_t insertPosition = path.rfind('.');
+        if (insertPosition == string::npos || path.find_first_of("/\\", insertPosition) != string::npos) {
+            insertPosition = path.size();
+        }
+        return string(path).insert(insertPosition, "." + name);
+    }
+
+    // sorts blocks of the elements as tasks, then merges neighbouring blocks as tasks, round after round
+    // std::inplace_merge keeps the order of equal elements, so the sort is stable like std::stable_sort
+    template <typename T, typename Compare>
+    void parallelStableSort(WorkStealingScheduler& scheduler, vector<T>& elements, Compare compare)
+    {
+        constexpr size_t MIN_BLOCK_SIZE = 1 << 16;
+        const size_t blockCount         = min<size_t>(scheduler.workerCount() * 4, elements.size() / MIN_BLOCK_SIZE);
+        if (blockCount < 2) {
+            ranges::stable_sort(elements, compare);
+            return;
+        }
+        vector<typename vector<T>::iterator> bounds;
+        for (size_t i = 0; i <= blockCount; ++i) {
+            bounds.push_back(elements.begin() + static_cast<ptrdiff_t>(elements.size() * i / blockCount));
+        }
+        TaskGroup sortTasks(scheduler);
+        for (size_t i = 0; i < blockCount; ++i) {
+            sortTasks.run([&bounds, &compare, i]() { stable_sort(bounds[i], bounds[i + 1], compare); });
+        }
+        sortTasks.wait();
+        for (size_t width = 1; width < blockCount; width *= 2) {
+            TaskGroup mergeTasks(scheduler);
+            for (size_t i = 0; i + width < blockCount; i += 2 * width) {
+                mergeTasks.run([&bounds, &compare, i, width, blockCount]() {
+                    inplace_merge(bounds[i], bounds[i + width], bounds[min(i + 2 * width, blockCount)], compare);
+                });
+            }
+            mergeTasks.wait();
+        }
+    }
+
+    // stable, so that words with equal points keep the order of the input
+    // the indices take 4 bytes unless there are more words, the sort moves half as much
+    template <typename Index>
+    void writeInOrderOfPoints(
+        WorkStealingScheduler& scheduler, const UniqueWords& uniqueWords, span<const int> points, ostream& output)
+    {
+        vector<Index> order(uniqueWords.words.size());
+        iota(order.begin(), order.end(), Index { 0 });
+        parallelStableSort(
+            scheduler, order, [&points](Index left, Index right) { return points[left] < points[right]; });
+        ranges::for_each(order, [&output, &uniqueWords, &points](Index i) {
+            output << uniqueWords.word(i) << ", " << points[i] << '\n';
+        });
+    }
+
+    // whenAll takes tasks without a result, the result of each file is kept aside
+    Task<> storeResult(Task<Expected<FileStats>> task, Expected<FileStats>& result)
+    {
+        result = co_await task;
+    }
+
+    Expected<vector<FileStats>> firstErrorOrStats(const vector<Expected<FileStats>>& results)
+    {
+        vector<FileStats> stats;
+        for (const Expected<FileStats>& result : results) {
+            if (!result) {
+                return result.error();
+            }
+            stats.push_back(*result);
+        }
+        return stats;
+    }
+
+    FileStats statsOf(const UniqueWords& uniqueWords)
+    {
+        return { uniqueWords.wordCount, uniqueWords.words.size(), uniqueWords.sketch.estimate() };
+    }
+
+    // the hashes of the tokenizer, or of the keys, into the sketch of the chunk
+    void sketchWords(Chunk& chunk)
+    {
+        chunk.sketch.clear();
+        for (const uint64_t hash : chunk.hashes) {
+            chunk.sketch.add(hash);
+        }
+    }
+} // namespace
+
+FileProcessor::FileProcessor() : FileProcessor(ProcessingOptions())
+{
+}
+
+FileProcessor::FileProcessor(const ProcessingOptions& options, pmr::memory_resource* memory) :
+    options(options),
+    memory(memory),
+    scoringSchemes(options.scoringSchemes),
+    scheduler(make_unique<WorkStealingScheduler>(options.threadCount, options.pinWorkers, options.spreadOverNodes)),
+    blockingCalls(make_unique<BlockingCallPool>(options.ioThreadCount))
+{
+    if (scoringSchemes.empty()) {
+        scoringSchemes.push_back(ScoringScheme::defaultScheme());
+        useDefaultScorer = true;
+    }
+}
+
+FileProcessor::~FileProcessor() = default;
+
+Expected<void> FileProcessor::checkOutputPaths(const vector<pair<string, string>>& inputAndOutputPaths) const
+{
+    set<filesystem::path> paths;
+    const auto addPath = [&paths](const string& path) -> Expected<void> {
+        if (!paths.insert(filesystem::path(path).lexically_normal()).second) {
+            return Error { ErrorCode::FileOpen, "Error - The output file " + path + " would be written twice." };
+        }
+        return {};
+    };
+    for (const string& outputPath : inputAndOutputPaths | views::values) {
+        for (const string& outputPathForScheme : getOutputPaths(outputPath)) {
+            if (Expected<void> added = addPath(outputPathForScheme); !added) {
+                return added;
+            }
+        }
+        if (options.invalidInputPolicy != InvalidInputPolicy::Abort) {
+            if (Expected<void> added = addPath(getInvalidInputReportPath(outputPath)); !added) {
+                return added;
+            }
+        }
+    }
+    return {};
+}
+
+Expected<vector<FileStats>> FileProcessor::processFiles(const vector<pair<string, string>>& inputAndOutputPaths) const
+{
+    if (Expected<void> checked = checkOutputPaths(inputAndOutputPaths); !checked) {
+        return checked.error();
+    }
+    vector<Expected<FileStats>> results(inputAndOutputPaths.size(), FileStats {});
+    if (options.useAsync) {
+        vector<Task<>> fileTasks;
+        for (size_t i = 0; i < inputAndOutputPaths.size(); ++i) {
+            const auto& [inputPath, outputPath] = inputAndOutputPaths[i];
+            fileTasks.push_back(storeResult(processFileAsync(inputPath, outputPath), results[i]));
+        }
+        syncWait(whenAll(std::move(fileTasks)));
+        return firstErrorOrStats(results);
+    }
+    // one job per file, the jobs share the workers with the chunk and merge tasks
+    TaskGroup fileJobs(*scheduler);
+    for (size_t i = 0; i < inputAndOutputPaths.size(); ++i) {
+        fileJobs.run([this, &inputAndOutputPaths, &results, i]() {
+            results[i] = process(inputAndOutputPaths[i].first, inputAndOutputPaths[i].second);
+        });
+    }
+    fileJobs.wait();
+    return firstErrorOrStats(results);
+}
+
+Expected<FileStats> FileProcessor::process(const string& inputPath, const string& outputPath) const
+{
+    const Expected<UniqueWords> uniqueWords = createPairingUniqueWordsToPoints(inputPath);
+    if (!uniqueWords) {
+        return uniqueWords.error();
+    }
+    if (Expected<void> created = createSortedOutputFiles(outputPath, *uniqueWords); !created) {
+        return created.error();
+    }
+    if (Expected<void> reported = createInvalidInputReport(outputPath, *uniqueWords); !reported) {
+        return reported.error();
+    }
+    return statsOf(*uniqueWords);
+}
+
+UniqueWords FileProcessor::createUniqueWords() const
+{
+    UniqueWords uniqueWords(memory);
+    uniqueWords.arena = WordArena(options.useHugePages);
+    uniqueWords.pointsPerScheme.resize(scoringSchemes.size());
+    return uniqueWords;
+}
+
+Expected<unique_ptr<ByteSource>> FileProcessor::openInput(const string& inputPath) const
+{
+    Expected<unique_ptr<ByteSource>> source = openByteSource(inputPath, options.ioBackend);
+    if (!source) {
+        return source;
+    }
+    return decodeInput(std::move(*source), options.inputEncoding);
+}
+
+Expected<UniqueWords> FileProcessor::createPairingUniqueWordsToPoints(const string& inputPath) const
+{
+    const Expected<unique_ptr<ByteSource>> input = openInput(inputPath);
+    if (!input) {
+        return input.error();
+    }
+    if (options.deduplicationMode == DeduplicationMode::Partitioned) {
+        return createPairingUniqueWordsByPartition(**input);
+    }
+
+    UniqueWords uniqueWords = createUniqueWords();
+    WordSet hashSetProcessedWords(options.useHugePages);
+    if (options.presizeTables) {
+        Expected<HyperLogLog> sketch = sketchInput(inputPath);
+        if (!sketch) {
+            return sketch.error();
+        }
+        reserveUniqueWords(sketch->upperBound(), hashSetProcessedWords, uniqueWords);
+    }
+    // the tokenizers run in parallel, the deduplication runs in input order on this thread
+    const auto tokenizeStage = [this](Chunk& chunk) { return tokenizeAndScore(chunk); };
+    const auto consumeStage  = [this, &hashSetProcessedWords, &uniqueWords](Chunk& chunk) -> Expected<void> {
+        processChunkWithoutDuplicates(chunk, hashSetProcessedWords, uniqueWords);
+        return {};
+    };
+    ProcessingPipeline pipeline(options, *scheduler, memory);
+    if (Expected<void> processed = pipeline.run(**input, tokenizeStage, consumeStage); !processed) {
+        return processed.error();
+    }
+    return uniqueWords;
+}
+
+// the chunks are split by partition in the parallel stage, the ordered stage only keeps their slices in order
+Expected<UniqueWords> FileProcessor::createPairingUniqueWordsByPartition(ByteSource& input) const
+{
+    UniqueWords uniqueWords = createUniqueWords();
+    PartitionedDeduplicator deduplicator(scoringSchemes.size(), options.useHugePages);
+    const auto splitStage = [this, &deduplicator](Chunk& chunk) -> Expected<void> {
+        if (Expected<void> tokenized = tokenizeAndScore(chunk); !tokenized) {
+            return tokenized;
+        }
+        deduplicator.split(chunk, chunk.partitionSlices);
+        return {};
+    };
+    const auto appendStage = [this, &deduplicator, &uniqueWords](Chunk& chunk) -> Expected<void> {
+        collectChunkTotals(chunk, uniqueWords);
+        deduplicator.append(std::move(chunk.partitionSlices));
+        return {};
+    };
+    ProcessingPipeline pipeline(options, *scheduler, memory);
+    if (Expected<void> processed = pipeline.run(input, splitStage, appendStage); !processed) {
+        return processed.error();
+    }
+    deduplicator.finish(*scheduler, uniqueWords);
+    return uniqueWords;
+}
+
+// the sketches of the chunks are filled by the tokenizing tasks and merged in the ordered stage
+Expected<HyperLogLog> FileProcessor::sketchInput(const string& inputPath) const
+{
+    const Expected<unique_ptr<ByteSource>> input = openInput(inputPath);
+    if (!input) {
+        return input.error();
+    }
+    HyperLogLog sketch;
+    const Tokenizer tokenizer(false, options.caseFolding == CaseFolding::Lower);
+    const auto tokenizeStage = [&tokenizer](Chunk& chunk) -> Expected<void> {
+        tokenizer.tokenize(chunk);
+        sketchWords(chunk);
+        return {};
+    };
+    const auto mergeStage = [&sketch](Chunk& chunk) -> Expected<void> {
+        sketch.merge(chunk.sketch);
+        return {};
+    };
+    ProcessingPipeline pipeline(options, *scheduler, memory);
+    if (Expected<void> processed = pipeline.run(**input, tokenizeStage, mergeStage); !processed) {
+        return processed.error();
+    }
+    return sketch;
+}
+
+Task<Expected<FileStats>> FileProcessor::processFileAsync(string inputPath, string outputPath) const
+{
+    size_t uniqueWordCapacity = 0;
+    if (options.presizeTables && options.deduplicationMode == DeduplicationMode::Ordered) {
+        Expected<HyperLogLog> sketch = co_await sketchInputAsync(inputPath);
+        if (!sketch) {
+            co_return sketch.error();
+        }
+        uniqueWordCapacity = sketch->upperBound();
+    }
+    const Expected<unique_ptr<ByteSource>> input = openInput(inputPath);
+    if (!input) {
+        co_return input.error();
+    }
+    const Expected<UniqueWords> uniqueWords = co_await processAsync(**input, uniqueWordCapacity);
+    if (!uniqueWords) {
+        co_return uniqueWords.error();
+    }
+    if (Expected<void> created = createSortedOutputFiles(outputPath, *uniqueWords); !created) {
+        co_return created.error();
+    }
+    if (Expected<void> reported = createInvalidInputReport(outputPath, *uniqueWords); !reported) {
+        co_return reported.error();
+    }
+    co_return statsOf(*uniqueWords);
+}
+
+Task<Expected<void>> FileProcessor::readChunkAsync(ByteSource& input, ChunkReader& chunkReader, Chunk& chunk) const
+{
+    chunkReader.begin(chunk);
+    Expected<size_t> readCount = size_t { 0 };
+    do {
+        readCount = co_await ReadAwaitable(input, chunkReader.nextRead(chunk), *blockingCalls, *scheduler);
+        if (!readCount) {
+            co_return readCount.error();
+        }
+    } while (!chunkReader.commit(chunk, *readCount));
+    co_return Expected<void>();
+}
+
+Task<Expected<HyperLogLog>> FileProcessor::sketchInputAsync(string inputPath) const
+{
+    const Expected<unique_ptr<ByteSource>> input = openInput(inputPath);
+    if (!input) {
+        co_return input.error();
+    }
+    HyperLogLog sketch;
+    const Tokenizer tokenizer(false, options.caseFolding == CaseFolding::Lower);
+    ChunkReader chunkReader(options.chunkSize, options.invalidInputPolicy == InvalidInputPolicy::SkipLine);
+    Chunk chunk(options.useHugePages, memory);
+    while (!chunkReader.isEndOfInput()) {
+        if (Expected<void> read = co_await readChunkAsync(**input, chunkReader, chunk); !read) {
+            co_return read.error();
+        }
+        tokenizer.tokenize(chunk);
+        for (const uint64_t hash : chunk.hashes) {
+            sketch.add(hash);
+        }
+        co_await YieldAwaitable(*scheduler);
+    }
+    co_return sketch;
+}
+
+// one chunk at a time: the coroutine suspends while the chunk is read, and yields to the scheduler
+// between chunks, so that a few workers can serve many inputs
+Task<Expected<UniqueWords>> FileProcessor::processAsync(ByteSource& input, size_t uniqueWordCapacity) const
+{
+    UniqueWords uniqueWords = createUniqueWords();
+    WordSet hashSetProcessedWords(options.useHugePages);
+    if (uniqueWordCapacity != 0) {
+        reserveUniqueWords(uniqueWordCapacity, hashSetProcessedWords, uniqueWords);
+    }
+    const bool isPartitioned = options.deduplicationMode == DeduplicationMode::Partitioned;
+    PartitionedDeduplicator deduplicator(scoringSchemes.size(), options.useHugePages);
+    ChunkReader chunkReader(options.chunkSize, options.invalidInputPolicy == InvalidInputPolicy::SkipLine);
+    Chunk chunk(options.useHugePages, memory);
+    while (!chunkReader.isEndOfInput()) {
+        if (Expected<void> read = co_await readChunkAsync(input, chunkReader, chunk); !read) {
+            co_return read.error();
+        }
+        if (Expected<void> tokenized = tokenizeAndScore(chunk); !tokenized) {
+            co_return tokenized.error();
+        }
+        if (isPartitioned) {
+            collectChunkTotals(chunk, uniqueWords);
+            deduplicator.split(chunk, chunk.partitionSlices);
+            deduplicator.append(std::move(chunk.partitionSlices));
+        } else {
+            processChunkWithoutDuplicates(chunk, hashSetProcessedWords, uniqueWords);
+        }
+        co_await YieldAwaitable(*scheduler);
+    }
+    if (isPartitioned) {
+        deduplicator.finish(*scheduler, uniqueWords);
+    }
+    co_return uniqueWords;
+}
+
+// the words are scored here, in the parallel stage, rather than once unique in the ordered stage:
+// every word has to be validated anyway, and the score comes with the same walk over the bytes
+Expected<void> FileProcessor::tokenizeAndScore(Chunk& chunk) const
+{
+    constexpr size_t BATCH_SIZE = 1024;
+    const Tokenizer tokenizer(
+        options.invalidInputPolicy != InvalidInputPolicy::Abort, options.caseFolding == CaseFolding::Lower);
+    tokenizer.tokenize(chunk);
+    chunk.invalidInputs.clear();
+    pmr::vector<size_t> invalidWords(chunk.memory->resource());
+    const size_t schemeCount = scoringSchemes.size();
+    chunk.points.assign(chunk.words.size() * schemeCount, 0);
+    // the words were compacted in place, so they are all within the chunk buffer
+    array<uint32_t, BATCH_SIZE> offsets;
+    array<uint32_t, BATCH_SIZE> lengths;
+    for (size_t first = 0; first < chunk.words.size(); first += BATCH_SIZE) {
+        const size_t count = min(BATCH_SIZE, chunk.words.size() - first);
+        for (size_t i = 0; i < count; ++i) {
+            offsets[i] = static_cast<uint32_t>(chunk.words[first + i].data() - chunk.buffer.data());
+            lengths[i] = static_cast<uint32_t>(chunk.words[first + i].size());
+        }
+        const WordBatch batch { chunk.buffer.data(), span(offsets).first(count), span(lengths).first(count) };
+        const size_t invalidWord =
+            scoreBatch(batch, span(chunk.points).subspan(first * schemeCount, count * schemeCount));
+        if (invalidWord == word_batch::NO_INVALID_WORD) {
+            continue;
+        }
+        // the input reaches the tokenizer as UTF-8, other encodings are decoded by openInput
+        if (options.invalidInputPolicy == InvalidInputPolicy::Abort) {
+            return Error { ErrorCode::NonUtf8Characters, "Error - NonUtf8CharactersFoundException" };
+        }
+        // the batch only tells the first invalid word, the rare batches holding one are checked word by word
+        for (size_t i = first + invalidWord; i < first + count; ++i) {
+            if (string_utilities::decodeUtf8(chunk.words[i], [](char32_t) {}) != string_view::npos) {
+                invalidWords.push_back(i);
+            }
+        }
+    }
+    if (!invalidWords.empty()) {
+        handleInvalidWords(chunk, invalidWords);
+    }
+    if (options.normalizeToNfc) {
+        normalizeWords(chunk);
+    }
+    if (options.caseFolding == CaseFolding::KeepSpelling) {
+        makeLowercaseKeys(chunk);
+    }
+    // the hashes are final once the words are repaired, normalized and given their keys
+    sketchWords(chunk);
+    return {};
+}
+
+size_t FileProcessor::scoreBatch(const WordBatch& batch, span<int> points) const
+{
+    size_t invalidWord = 0;
+    if (useDefaultScorer) {
+        // the scheme is known at build time, the scorer is specialized for it
+        invalidWord = word_batch::countPoints(DefaultScorer(), batch, points);
+    } else {
+        const size_t schemeCount = scoringSchemes.size();
+        invalidWord = word_batch::decode(batch, [this, &points, schemeCount](size_t word, char32_t codepoint) {
+            for (size_t scheme = 0; scheme < schemeCount; ++scheme) {
+                points[word * schemeCount + scheme] += scoringSchemes[scheme]->points(codepoint);
+            }
+        });
+    }
+    return invalidWord;
+}
+
+void FileProcessor::handleInvalidWords(Chunk& chunk, span<const size_t> invalidWords) const
+{
+    const size_t schemeCount = scoringSchemes.size();
+    if (options.invalidInputPolicy == InvalidInputPolicy::Replace) {
+        // the repaired words are longer, they are gathered in chunk.repairs and pointed to once all are written
+        chunk.repairs.clear();
+        pmr::vector<size_t> repairOffsets(chunk.memory->resource());
+        for (const size_t word : invalidWords) {
+            const WordPosition& position = chunk.wordPositions[word];
+            chunk.invalidInputs.push_back({ chunk.inputOffset + position.offset, position.length });
+            repairOffsets.push_back(chunk.repairs.size());
+            string_view rest = chunk.words[word];
+            while (!rest.empty()) {
+                const size_t invalidPosition = string_utilities::decodeUtf8(rest, [](char32_t) {});
+                chunk.repairs.append(rest.substr(0, invalidPosition));
+                if (invalidPosition == string_view::npos) {
+                    break;
+                }
+                // one U+FFFD for the lead byte and the continuation bytes that it was followed by
+                chunk.repairs.append("\xEF\xBF\xBD");
+                const size_t invalidLength = string_utilities::invalidSequenceLength(
+                    rest.data() + invalidPosition, rest.size() - invalidPosition);
+                rest.remove_prefix(invalidPosition + invalidLength);
+            }
+        }
+        repairOffsets.push_back(chunk.repairs.size());
+        replaceWords(chunk, invalidWords, chunk.repairs, repairOffsets);
+        return;
+    }
+    // the words to leave out are flagged, then the others are moved down
+    pmr::vector<bool> isSkipped(chunk.words.size(), false, chunk.memory->resource());
+    for (const size_t word : invalidWords) {
+        const WordPosition& position = chunk.wordPositions[word];
+        if (options.invalidInputPolicy == InvalidInputPolicy::SkipWord) {
+            isSkipped[word] = true;
+            chunk.invalidInputs.push_back({ chunk.inputOffset + position.offset, position.length });
+            continue;
+        }
+        // the line runs from the line feed before the word to the line feed after it
+        const auto lineEnd   = ranges::lower_bound(chunk.lineEnds, position.offset);
+        const uint32_t start = lineEnd == chunk.lineEnds.begin() ? 0 : lineEnd[-1] + 1;
+        const uint32_t end   = lineEnd == chunk.lineEnds.end() ? static_cast<uint32_t>(chunk.size) : *lineEnd;
+        if (!chunk.invalidInputs.empty() && chunk.invalidInputs.back().inputOffset == chunk.inputOffset + start) {
+            continue;
+        }
+        chunk.invalidInputs.push_back({ chunk.inputOffset + start, end - start });
+        // the words are in input order, so the words of the line are found by bisection
+        const auto byOffset  = [](const WordPosition& wordPosition) { return wordPosition.offset; };
+        const auto lineBegin = ranges::lower_bound(chunk.wordPositions, start, {}, byOffset);
+        const auto lineStop  = ranges::lower_bound(chunk.wordPositions, end, {}, byOffset);
+        fill(isSkipped.begin() + (lineBegin - chunk.wordPositions.begin()),
+            isSkipped.begin() + (lineStop - chunk.wordPositions.begin()),
+            true);
+    }
+    size_t kept = 0;
+    for (size_t word = 0; word < chunk.words.size(); ++word) {
+        if (isSkipped[word]) {
+            continue;
+        }
+        chunk.words[kept]  = chunk.words[word];
+        chunk.hashes[kept] = chunk.hashes[word];
+        copy_n(chunk.points.begin() + static_cast<ptrdiff_t>(word * schemeCount),
+            schemeCount,
+            chunk.points.begin() + static_cast<ptrdiff_t>(kept * schemeCount));
+        ++kept;
+    }
+    chunk.words.resize(kept);
+    chunk.hashes.resize(kept);
+    chunk.points.resize(kept * schemeCount);
+}
+
+// the words made of characters below U+0300 only, nearly all of them, are in NFC already and are not decoded
+void FileProcessor::normalizeWords(Chunk& chunk) const
+{
+    chunk.normalizedWords.clear();
+    NfcNormalizer normalizer;
+    pmr::vector<size_t> changedWords(chunk.memory->resource());
+    pmr::vector<size_t> offsets(chunk.memory->resource());
+    for (size_t word = 0; word < chunk.words.size(); ++word) {
+        if (NfcNormalizer::isQuickNfc(chunk.words[word])) {
+            continue;
+        }
+        const size_t offset = chunk.normalizedWords.size();
+        if (normalizer.appendNormalized(chunk.words[word], chunk.normalizedWords)) {
+            changedWords.push_back(word);
+            offsets.push_back(offset);
+        }
+    }
+    if (changedWords.empty()) {
+        return;
+    }
+    offsets.push_back(chunk.normalizedWords.size());
+    replaceWords(chunk, changedWords, chunk.normalizedWords, offsets);
+}
+
+// the keys are gathered in one string and lowered in one run, then pointed to and hashed
+void FileProcessor::makeLowercaseKeys(Chunk& chunk) const
+{
+    chunk.lowercaseWords.clear();
+    for (const string_view word : chunk.words) {
+        chunk.lowercaseWords.append(word);
+    }
+    case_folding::toLowercase(chunk.lowercaseWords);
+    chunk.keys.clear();
+    size_t offset = 0;
+    for (size_t i = 0; i < chunk.words.size(); ++i) {
+        chunk.keys.push_back(string_view(chunk.lowercaseWords).substr(offset, chunk.words[i].size()));
+        chunk.hashes[i] = string_utilities::hashWord(chunk.keys.back());
+        offset += chunk.words[i].size();
+    }
+}
+
+// the storage is complete before any view points into it, so that no view is left dangling by its growth
+void FileProcessor::replaceWords(
+    Chunk& chunk, span<const size_t> words, string_view storage, span<const size_t> offsets) const
+{
+    const size_t schemeCount = scoringSchemes.size();
+    for (size_t i = 0; i < words.size(); ++i) {
+        const size_t word      = words[i];
+        const uint32_t offset  = static_cast<uint32_t>(offsets[i]);
+        const uint32_t length  = static_cast<uint32_t>(offsets[i + 1] - offsets[i]);
+        const span<int> points = span(chunk.points).subspan(word * schemeCount, schemeCount);
+        chunk.words[word]      = storage.substr(offset, length);
+        chunk.hashes[word]     = string_utilities::hashWord(chunk.words[word]);
+        ranges::fill(points, 0);
+        scoreBatch({ storage.data(), span(&offset, 1), span(&length, 1) }, points);
+    }
+}
+
+void FileProcessor::collectChunkTotals(const Chunk& chunk, UniqueWords& uniqueWords) const
+{
+    uniqueWords.invalidInputs.insert(
+        uniqueWords.invalidInputs.end(), chunk.invalidInputs.begin(), chunk.invalidInputs.end());
+    uniqueWords.wordCount += chunk.words.size();
+    uniqueWords.sketch.merge(chunk.sketch);
+}
+
+void FileProcessor::reserveUniqueWords(size_t capacity, WordSet& hashSetProcessedWords, UniqueWords& uniqueWords) const
+{
+    hashSetProcessedWords.reserve(capacity);
+    uniqueWords.words.reserve(capacity);
+    for (pmr::vector<int>& points : uniqueWords.pointsPerScheme) {
+        points.reserve(capacity);
+    }
+}
+
+void FileProcessor::processChunkWithoutDuplicates(
+    const Chunk& chunk, WordSet& hashSetProcessedWords, UniqueWords& uniqueWords) const
+{
+    collectChunkTotals(chunk, uniqueWords);
+    const size_t schemeCount               = scoringSchemes.size();
+    const pmr::vector<string_view>& words = chunk.words;
+    const pmr::vector<string_view>& keys  = chunk.keys.empty() ? chunk.words : chunk.keys;
+    // there must be no duplicates, a word is kept when its key is new
+    hashSetProcessedWords.insertBatch(keys, chunk.hashes, [&](size_t i, string_view& storedKey) {
+        // the word lives in the chunk buffer, which is reused, so the set keeps a copy owned by the arena
+        const ArenaWord word = uniqueWords.arena.store(words[i]);
+        processWordForPairingToPoints(word, span(chunk.points).subspan(i * schemeCount, schemeCount), uniqueWords);
+        storedKey = uniqueWords.arena.view(keys[i] == words[i] ? word : uniqueWords.arena.store(keys[i]));
+    });
+}
+
+vector<string> FileProcessor::getOutputPaths(const string& outputPath) const
+{
+    if (scoringSchemes.size() == 1) {
+        return { outputPath };
+    }
+    vector<string> outputPaths;
+    for (const auto& scoringScheme : scoringSchemes) {
+        outputPaths.push_back(insertBeforeExtension(outputPath, scoringScheme->getName()));
+    }
+    return outputPaths;
+}
+
+string FileProcessor::getInvalidInputReportPath(const string& outputPath) const
+{
+    return insertBeforeExtension(outputPath, "invalid");
+}
+
+Expected<void> FileProcessor::createInvalidInputReport(const string& outputPath, const UniqueWords& uniqueWords) const
+{
+    if (options.invalidInputPolicy == InvalidInputPolicy::Abort) {
+        return {};
+    }
+    fstream reportFile;
+    reportFile.open(getInvalidInputReportPath(outputPath), ios::trunc | ios::out);
+    if (!reportFile.is_open()) {
+        return Error { ErrorCode::FileOpen, "Error - Impossible to open the invalid input report file." };
+    }
+    ranges::for_each(uniqueWords.invalidInputs, [&reportFile](const InvalidInput& invalidInput) {
+        reportFile << invalidInput.inputOffset << ", " << invalidInput.length << '\n';
+    });
+    return {};
+}
+
+Expected<void> FileProcessor::createSortedOutputFiles(const string& outputPath, const UniqueWords& uniqueWords) const
+{
+    const vector<string> outputPaths = getOutputPaths(outputPath);
+    for (size_t scheme = 0; scheme < scoringSchemes.size(); ++scheme) {
+        fstream outputFile;
+        outputFile.open(outputPaths[scheme], ios::trunc | ios::out);
+        if (!outputFile.is_open()) {
+            return Error { ErrorCode::FileOpen, "Error - Impossible to open the output file." };
+        }
+        // the words stay in place, each scheme sorts its own order of the indices
+        if (uniqueWords.words.size() <= numeric_limits<uint32_t>::max()) {
+            writeInOrderOfPoints<uint32_t>(*scheduler, uniqueWords, uniqueWords.pointsPerScheme[scheme], outputFile);
+        } else {
+            writeInOrderOfPoints<size_t>(*scheduler, uniqueWords, uniqueWords.pointsPerScheme[scheme], outputFile);
+        }
+    }
+    return {};
+}
+
+void FileProcessor::processWordForPairingToPoints(ArenaWord word, span<const int> points, UniqueWords& uniqueWords) const
+{
+    uniqueWords.words.push_back(word);
+    for (size_t scheme = 0; scheme < points.size(); ++scheme) {
+        uniqueWords.pointsPerScheme[scheme].push_back(points[scheme]);
+    }
+}
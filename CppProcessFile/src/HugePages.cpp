@@ -0,0 +1,101 @@
+#include "HugePages.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+namespace
+{
+    size_t roundToHugePages(size_t size)
+    {
+        return (size + huge_pages::HUGE_PAGE_SIZE - 1) & ~(huge_pages::HUGE_PAGE_SIZE - 1);
+    }
+
+    [[noreturn]] void failAllocation()
+    {
+#if defined(__cpp_exceptions)
+        throw bad_alloc();
+#else
+        abort();
+#endif
+    }
+} // namespace
+#endif
+
+void* huge_pages::allocate(size_t size)
+{
+#ifdef __linux__
+    constexpr int PROTECTION = PROT_READ | PROT_WRITE;
+    const size_t mappedSize  = roundToHugePages(size);
+    void* memory             = mmap(nullptr, mappedSize, PROTECTION, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+        return memory;
+    }
+    // no explicit huge page is left, a huge page more is mapped so that the part kept can start on a boundary
+    char* reserved = static_cast<char*>(
+        mmap(nullptr, mappedSize + HUGE_PAGE_SIZE, PROTECTION, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (reserved == MAP_FAILED) {
+        failAllocation();
+    }
+    const uintptr_t address = reinterpret_cast<uintptr_t>(reserved);
+    char* start             = reserved + (roundToHugePages(address) - address);
+    if (start != reserved) {
+        munmap(reserved, static_cast<size_t>(start - reserved));
+    }
+    if (const size_t tail = static_cast<size_t>(reserved + HUGE_PAGE_SIZE - start); tail != 0) {
+        munmap(start + mappedSize, tail);
+    }
+    // the advice is ignored when the kernel has the transparent huge pages disabled
+    madvise(start, mappedSize, MADV_HUGEPAGE);
+    return start;
+#else
+    return ::operator new(size);
+#endif
+}
+
+void huge_pages::deallocate(void* memory, size_t size)
+{
+#ifdef __linux__
+    munmap(memory, roundToHugePages(size));
+#else
+    ::operator delete(memory, size);
+#endif
+}
+
+PageBuffer::PageBuffer(size_t size, bool usesHugePages) :
+    allocator(usesHugePages), bytes(allocator.allocate(size)), size(size)
+{
+}
+
+PageBuffer::PageBuffer(PageBuffer&& other) noexcept :
+    allocator(other.allocator), bytes(exchange(other.bytes, nullptr)), size(exchange(other.size, 0))
+{
+}
+
+PageBuffer& PageBuffer::operator=(PageBuffer&& other) noexcept
+{
+    if (this != &other) {
+        if (bytes != nullptr) {
+            allocator.deallocate(bytes, size);
+        }
+        allocator = other.allocator;
+        bytes     = exchange(other.bytes, nullptr);
+        size      = exchange(other.size, 0);
+    }
+    return *this;
+}
+
+PageBuffer::~PageBuffer()
+{
+    if (bytes != nullptr) {
+        allocator.deallocate(bytes, size);
+    }
+}
@@ -0,0 +1,47 @@
+#include "HyperLogLog.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+HyperLogLog::HyperLogLog() : registers(REGISTER_COUNT, 0)
+{
+}
+
+void HyperLogLog::merge(const HyperLogLog& other)
+{
+    for (size_t i = 0; i < REGISTER_COUNT; ++i) {
+        registers[i] = max(registers[i], other.registers[i]);
+    }
+}
+
+void HyperLogLog::clear()
+{
+    ranges::fill(registers, 0);
+}
+
+// the harmonic mean of the registers, corrected by linear counting of the empty registers for few words,
+// where the mean is biased
+size_t HyperLogLog::estimate() const
+{
+    const double registerCount = static_cast<double>(REGISTER_COUNT);
+    double sum                 = 0;
+    size_t emptyCount          = 0;
+    for (const uint8_t rank : registers) {
+        sum += ldexp(1.0, -rank);
+        emptyCount += rank == 0;
+    }
+    const double alpha = 0.7213 / (1 + 1.079 / registerCount);
+    double estimate    = alpha * registerCount * registerCount / sum;
+    if (estimate <= 2.5 * registerCount && emptyCount != 0) {
+        estimate = registerCount * log(registerCount / static_cast<double>(emptyCount));
+    }
+    return static_cast<size_t>(llround(estimate));
+}
+
+size_t HyperLogLog::upperBound() const
+{
+    const size_t estimated = estimate();
+    return estimated + estimated / 30;
+}
@@ -0,0 +1,418 @@
+#include "InputEncoding.h"
+#include "StringUtilities.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // the bytes read ahead to detect the encoding
+    constexpr size_t DETECTION_SIZE = 64 * 1024;
+    constexpr string_view UTF8_BOM  = "\xEF\xBB\xBF";
+    // the bytes read from the source at a time
+    constexpr size_t RAW_BLOCK_SIZE = 64 * 1024;
+    // a byte of input takes at most 3 bytes in UTF-8
+    constexpr size_t MAX_EXPANSION = 3;
+
+    // the code points of the bytes 0x80 to 0x9F in Windows-1252, the 5 unassigned bytes keep their Latin-1 meaning
+    constexpr array<char32_t, 32> CP1252_HIGH_CONTROLS = { 0x20AC,
+        0x0081,
+        0x201A,
+        0x0192,
+        0x201E,
+        0x2026,
+        0x2020,
+        0x2021,
+        0x02C6,
+        0x2030,
+        0x0160,
+        0x2039,
+        0x0152,
+        0x008D,
+        0x017D,
+        0x008F,
+        0x0090,
+        0x2018,
+        0x2019,
+        0x201C,
+        0x201D,
+        0x2022,
+        0x2013,
+        0x2014,
+        0x02DC,
+        0x2122,
+        0x0161,
+        0x203A,
+        0x0153,
+        0x009D,
+        0x017E,
+        0x0178 };
+
+    struct Utf8Sequence
+    {
+        array<char, 4> bytes;
+        uint8_t length;
+    };
+
+    // the UTF-8 sequence of each of the 256 bytes
+    array<Utf8Sequence, 256> makeSequences(InputEncoding encoding)
+    {
+        array<Utf8Sequence, 256> sequences {};
+        for (char32_t byte = 0; byte < sequences.size(); ++byte) {
+            const bool isHighControl = byte >= 0x80 && byte < 0xA0;
+            const char32_t codepoint =
+                encoding == InputEncoding::Cp1252 && isHighControl ? CP1252_HIGH_CONTROLS[byte - 0x80] : byte;
+            const size_t length      = string_utilities::encodeUtf8(codepoint, sequences[byte].bytes.data());
+            sequences[byte].length   = static_cast<uint8_t>(length);
+        }
+        return sequences;
+    }
+
+    // true when the bytes can be the start of a UTF-8 input, a sequence cut by the end of the block is accepted
+    bool isUtf8(const vector<char>& bytes, bool isWholeInput)
+    {
+        for (size_t position = 0; position < bytes.size();) {
+            const auto lead = static_cast<unsigned char>(bytes[position]);
+            if (lead < 0x80) {
+                ++position;
+                continue;
+            }
+            const size_t length = countl_one(lead);
+            if (length < 2 || length > 4 || lead < 0xC2 || lead > 0xF4) {
+                return false;
+            }
+            for (size_t i = 1; i < length; ++i) {
+                if (position + i == bytes.size()) {
+                    return !isWholeInput;
+                }
+                if ((static_cast<unsigned char>(bytes[position + i]) & 0xC0) != 0x80) {
+                    return false;
+                }
+            }
+            position += length;
+        }
+        return true;
+    }
+
+    // serves the bytes read ahead for the detection, then the rest of the source
+    class ReplayByteSource : public ByteSource
+    {
+    public:
+        ReplayByteSource(unique_ptr<ByteSource> source, vector<char> readAhead) :
+            source(std::move(source)),
+            readAhead(std::move(readAhead))
+        {
+        }
+
+        Expected<size_t> read(char* destination, size_t capacity) override
+        {
+            if (readAheadPosition == readAhead.size()) {
+                return source->read(destination, capacity);
+            }
+            const size_t count = min(capacity, readAhead.size() - readAheadPosition);
+            memcpy(destination, readAhead.data() + readAheadPosition, count);
+            readAheadPosition += count;
+            return count;
+        }
+
+        bool isReadReady() const override
+        {
+            return readAheadPosition < readAhead.size() || source->isReadReady();
+        }
+
+    private:
+        unique_ptr<ByteSource> source;
+        vector<char> readAhead;
+        size_t readAheadPosition = 0;
+    };
+
+    struct DecodedBlock
+    {
+        size_t consumed;
+        size_t written;
+    };
+
+    // decodes the source block by block into the buffers of the reader
+    // the derived decoders turn a block of bytes into UTF-8, and may leave an incomplete code unit for the next block
+    class BlockDecoder : public ByteSource
+    {
+    public:
+        BlockDecoder(unique_ptr<ByteSource> source, vector<char> readAhead) :
+            source(std::move(source)),
+            raw(std::move(readAhead)),
+            rawEnd(raw.size())
+        {
+            raw.resize(max(raw.size(), RAW_BLOCK_SIZE));
+        }
+
+        Expected<size_t> read(char* destination, size_t capacity) override
+        {
+            while (true) {
+                if (pendingPosition < pendingSize) {
+                    const size_t count = min(capacity, pendingSize - pendingPosition);
+                    memcpy(destination, pending.data() + pendingPosition, count);
+                    pendingPosition += count;
+                    return count;
+                }
+                if (rawPosition < rawEnd) {
+                    // decoded in place when the destination holds the worst case, through pending otherwise
+                    const bool isInPlace     = capacity >= pending.size();
+                    const size_t outputSize  = isInPlace ? capacity : pending.size();
+                    const size_t count       = min(rawEnd - rawPosition, outputSize / MAX_EXPANSION);
+                    const DecodedBlock block = decode(raw.data() + rawPosition,
+                        count,
+                        isInPlace ? destination : pending.data(),
+                        isEndOfInput && rawPosition + count == rawEnd);
+                    rawPosition += block.consumed;
+                    if (!isInPlace) {
+                        pendingPosition = 0;
+                        pendingSize     = block.written;
+                    } else if (block.written > 0) {
+                        return block.written;
+                    }
+                    if (block.consumed > 0) {
+                        continue;
+                    }
+                }
+                // what is left is an incomplete code unit, or nothing
+                if (isEndOfInput) {
+                    return 0;
+                }
+                if (Expected<void> refilled = refill(); !refilled) {
+                    return refilled.error();
+                }
+            }
+        }
+
+        bool isReadReady() const override
+        {
+            return pendingPosition < pendingSize || rawPosition < rawEnd || source->isReadReady();
+        }
+
+    protected:
+        // a code unit takes at most 4 bytes, which become at most 12 bytes of UTF-8
+        static constexpr size_t MAX_UNIT_SIZE = 4;
+
+        // decodes whole code units of bytes, destination holds MAX_EXPANSION bytes per byte of count
+        // at the end of the input, an incomplete code unit must be consumed too
+        virtual DecodedBlock decode(const char* bytes, size_t count, char* destination, bool isLastBlock) = 0;
+
+    private:
+        Expected<void> refill()
+        {
+            const size_t leftover = rawEnd - rawPosition;
+            memmove(raw.data(), raw.data() + rawPosition, leftover);
+            rawPosition                      = 0;
+            const Expected<size_t> readCount = source->read(raw.data() + leftover, raw.size() - leftover);
+            if (!readCount) {
+                return readCount.error();
+            }
+            rawEnd       = leftover + *readCount;
+            isEndOfInput = *readCount == 0;
+            return {};
+        }
+
+        unique_ptr<ByteSource> source;
+        // the bytes read from the source and not decoded yet
+        vector<char> raw;
+        size_t rawPosition = 0;
+        size_t rawEnd      = 0;
+        bool isEndOfInput  = false;
+        // the decoded bytes of a read too small for the worst case
+        array<char, MAX_UNIT_SIZE * MAX_EXPANSION> pending {};
+        size_t pendingPosition = 0;
+        size_t pendingSize     = 0;
+    };
+
+    // Latin-1 and Windows-1252: ASCII is copied 8 bytes at a time, any other byte goes through a table
+    class SingleByteDecoder : public BlockDecoder
+    {
+    public:
+        SingleByteDecoder(unique_ptr<ByteSource> source, InputEncoding encoding, vector<char> readAhead) :
+            BlockDecoder(std::move(source), std::move(readAhead)),
+            sequences(makeSequences(encoding))
+        {
+        }
+
+    protected:
+        DecodedBlock decode(const char* bytes, size_t count, char* destination, bool /*isLastBlock*/) override
+        {
+            constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+            size_t written               = 0;
+            size_t position              = 0;
+            while (position < count) {
+                if (count - position >= sizeof(uint64_t)) {
+                    uint64_t block = 0;
+                    memcpy(&block, bytes + position, sizeof(block));
+                    if ((block & HIGH_BITS) == 0) {
+                        memcpy(destination + written, &block, sizeof(block));
+                        written += sizeof(block);
+                        position += sizeof(block);
+                        continue;
+                    }
+                }
+                // the sequences are copied whole, without branching on their length
+                const Utf8Sequence& sequence = sequences[static_cast<unsigned char>(bytes[position])];
+                memcpy(destination + written, sequence.bytes.data(), MAX_EXPANSION);
+                written += sequence.length;
+                ++position;
+            }
+            return { count, written };
+        }
+
+    private:
+        const array<Utf8Sequence, 256> sequences;
+    };
+
+    // UTF-16 in either byte order, the surrogate pairs may be split between two blocks
+    // a leading byte order mark is dropped, a lone surrogate is passed on as the invalid byte 0xFF,
+    // so that the tokenizer reports it like any other invalid input
+    class Utf16Decoder : public BlockDecoder
+    {
+    public:
+        Utf16Decoder(unique_ptr<ByteSource> source, bool isLittleEndian, vector<char> readAhead) :
+            BlockDecoder(std::move(source), std::move(readAhead)),
+            isLittleEndian(isLittleEndian)
+        {
+        }
+
+    protected:
+        DecodedBlock decode(const char* bytes, size_t count, char* destination, bool isLastBlock) override
+        {
+            // the high byte of each unit of 4 units, the units are ASCII when these and bit 7 of the low bytes are 0
+            const uint64_t nonAsciiBits = isLittleEndian ? 0xFF80FF80FF80FF80 : 0x80FF80FF80FF80FF;
+            const size_t lowByte        = isLittleEndian ? 0 : 1;
+            size_t written              = 0;
+            size_t position             = 0;
+            while (count - position >= 2) {
+                if (count - position >= sizeof(uint64_t)) {
+                    uint64_t block = 0;
+                    memcpy(&block, bytes + position, sizeof(block));
+                    if ((block & nonAsciiBits) == 0) {
+                        for (size_t i = 0; i < 4; ++i) {
+                            destination[written + i] = bytes[position + 2 * i + lowByte];
+                        }
+                        written += 4;
+                        position += sizeof(block);
+                        isAtStart = false;
+                        continue;
+                    }
+                }
+                const char32_t unit = readUnit(bytes + position);
+                if (unit >= 0xD800 && unit < 0xDC00) {
+                    if (count - position < 4) {
+                        // the low surrogate is in the next block
+                        break;
+                    }
+                    const char32_t low = readUnit(bytes + position + 2);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        const char32_t codepoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        written += string_utilities::encodeUtf8(codepoint, destination + written);
+                        position += 4;
+                    } else {
+                        destination[written++] = static_cast<char>(0xFF);
+                        position += 2;
+                    }
+                } else if (unit >= 0xDC00 && unit < 0xE000) {
+                    destination[written++] = static_cast<char>(0xFF);
+                    position += 2;
+                } else {
+                    if (!isAtStart || unit != 0xFEFF) {
+                        written += string_utilities::encodeUtf8(unit, destination + written);
+                    }
+                    position += 2;
+                }
+                isAtStart = false;
+            }
+            if (isLastBlock && position < count) {
+                // an odd byte count or a high surrogate ending the input
+                destination[written++] = static_cast<char>(0xFF);
+                position               = count;
+            }
+            return { position, written };
+        }
+
+    private:
+        char32_t readUnit(const char* bytes) const
+        {
+            const auto first  = static_cast<unsigned char>(bytes[0]);
+            const auto second = static_cast<unsigned char>(bytes[1]);
+            return isLittleEndian ? (second << 8) | first : (first << 8) | second;
+        }
+
+        const bool isLittleEndian;
+        bool isAtStart = true;
+    };
+
+    // reads size bytes ahead, fewer only when the input is shorter
+    Expected<vector<char>> readAhead(ByteSource& source, size_t size, bool& isWholeInput)
+    {
+        vector<char> bytes(size);
+        size_t readSize = 0;
+        isWholeInput    = false;
+        while (readSize < bytes.size() && !isWholeInput) {
+            const Expected<size_t> readCount = source.read(bytes.data() + readSize, bytes.size() - readSize);
+            if (!readCount) {
+                return readCount.error();
+            }
+            isWholeInput = *readCount == 0;
+            readSize += *readCount;
+        }
+        bytes.resize(readSize);
+        return bytes;
+    }
+} // namespace
+
+Expected<unique_ptr<ByteSource>> decodeInput(unique_ptr<ByteSource> source, InputEncoding encoding)
+{
+    switch (encoding) {
+    case InputEncoding::Utf8: {
+        // the byte order mark is dropped as under Auto, else it would stay glued to the first word
+        bool isWholeInput            = false;
+        Expected<vector<char>> start = readAhead(*source, UTF8_BOM.size(), isWholeInput);
+        if (!start) {
+            return start.error();
+        }
+        if (string_view(start->data(), start->size()) == UTF8_BOM) {
+            start->clear();
+        }
+        return make_unique<ReplayByteSource>(std::move(source), std::move(*start));
+    }
+    case InputEncoding::Latin1:
+    case InputEncoding::Cp1252:
+        return make_unique<SingleByteDecoder>(std::move(source), encoding, vector<char>());
+    case InputEncoding::Utf16Le:
+    case InputEncoding::Utf16Be:
+        return make_unique<Utf16Decoder>(std::move(source), encoding == InputEncoding::Utf16Le, vector<char>());
+    case InputEncoding::Auto:
+        break;
+    }
+    bool isWholeInput                     = false;
+    Expected<vector<char>> readAheadBlock = readAhead(*source, DETECTION_SIZE, isWholeInput);
+    if (!readAheadBlock) {
+        return readAheadBlock.error();
+    }
+    vector<char>& firstBlock = *readAheadBlock;
+    const string_view start(firstBlock.data(), firstBlock.size());
+    // the byte order mark tells the encoding, the UTF-16 decoder drops it by itself
+    if (start.starts_with("\xFF\xFE") || start.starts_with("\xFE\xFF")) {
+        const bool isLittleEndian = start.starts_with("\xFF\xFE");
+        return make_unique<Utf16Decoder>(std::move(source), isLittleEndian, std::move(firstBlock));
+    }
+    if (start.starts_with(UTF8_BOM)) {
+        firstBlock.erase(firstBlock.begin(), firstBlock.begin() + UTF8_BOM.size());
+        return make_unique<ReplayByteSource>(std::move(source), std::move(firstBlock));
+    }
+    if (isUtf8(firstBlock, isWholeInput)) {
+        return make_unique<ReplayByteSource>(std::move(source), std::move(firstBlock));
+    }
+    return make_unique<SingleByteDecoder>(std::move(source), InputEncoding::Cp1252, std::move(firstBlock));
+}
@@ -0,0 +1,175 @@
+#include "NfcNormalizer.h"
+#include "StringUtilities.h"
+#include "UnicodeData.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+using namespace std;
+
+namespace
+{
+    constexpr char32_t MAX_CODEPOINT = 0x10FFFF;
+    // the first character with a decomposition or a combining class
+    constexpr char32_t FIRST_DECOMPOSABLE = 0xC0;
+    constexpr char32_t FIRST_MARK         = 0x300;
+
+    // the Hangul syllables are composed of a leading consonant, a vowel and an optional trailing consonant
+    constexpr char32_t SYLLABLE_BASE        = 0xAC00;
+    constexpr char32_t LEADING_BASE         = 0x1100;
+    constexpr char32_t VOWEL_BASE           = 0x1161;
+    constexpr char32_t TRAILING_BASE        = 0x11A7;
+    constexpr char32_t LEADING_COUNT        = 19;
+    constexpr char32_t VOWEL_COUNT          = 21;
+    constexpr char32_t TRAILING_COUNT       = 28;
+    constexpr char32_t SYLLABLES_PER_LEADER = VOWEL_COUNT * TRAILING_COUNT;
+    constexpr char32_t SYLLABLE_COUNT       = LEADING_COUNT * SYLLABLES_PER_LEADER;
+
+    uint8_t combiningClass(char32_t codepoint)
+    {
+        if (codepoint < FIRST_MARK) {
+            return 0;
+        }
+        const auto range = ranges::upper_bound(combiningClassRanges, codepoint, {}, &CombiningClassRange::first);
+        if (range == combiningClassRanges.begin() || range[-1].last < codepoint) {
+            return 0;
+        }
+        return range[-1].combiningClass;
+    }
+
+    // the primary composite of the pair, 0 if there is none
+    char32_t composePair(char32_t first, char32_t second)
+    {
+        if (first >= LEADING_BASE && first < LEADING_BASE + LEADING_COUNT && second >= VOWEL_BASE &&
+            second < VOWEL_BASE + VOWEL_COUNT) {
+            return SYLLABLE_BASE + ((first - LEADING_BASE) * VOWEL_COUNT + (second - VOWEL_BASE)) * TRAILING_COUNT;
+        }
+        if (first >= SYLLABLE_BASE && first < SYLLABLE_BASE + SYLLABLE_COUNT &&
+            (first - SYLLABLE_BASE) % TRAILING_COUNT == 0 && second > TRAILING_BASE &&
+            second < TRAILING_BASE + TRAILING_COUNT) {
+            return first + (second - TRAILING_BASE);
+        }
+        const auto byPair = [](const CanonicalComposition& composition) {
+            return pair(composition.first, composition.second);
+        };
+        const auto composition = ranges::lower_bound(canonicalCompositions, pair(first, second), {}, byPair);
+        if (composition == canonicalCompositions.end() || composition->first != first ||
+            composition->second != second) {
+            return 0;
+        }
+        return composition->composite;
+    }
+} // namespace
+
+// a character from U+0300 up starts with a lead byte from 0xCC up: with the high bit of a byte set and its low
+// bits from 0x4C up, adding 0x34 to the low bits sets the high bit, without carrying into the next byte
+bool NfcNormalizer::isQuickNfc(string_view word)
+{
+    constexpr uint64_t ONES      = 0x0101010101010101;
+    constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+    size_t position              = 0;
+    for (; word.size() - position >= sizeof(uint64_t); position += sizeof(uint64_t)) {
+        uint64_t bytes = 0;
+        memcpy(&bytes, word.data() + position, sizeof(bytes));
+        if ((bytes & ((bytes & ~HIGH_BITS) + 0x34 * ONES) & HIGH_BITS) != 0) {
+            return false;
+        }
+    }
+    return none_of(word.begin() + static_cast<ptrdiff_t>(position), word.end(), [](char c) {
+        return static_cast<unsigned char>(c) >= 0xCC;
+    });
+}
+
+bool NfcNormalizer::appendNormalized(string_view word, pmr::string& destination)
+{
+    original.clear();
+    codepoints.clear();
+    for (size_t position = 0; position < word.size();) {
+        const char32_t codepoint = string_utilities::decodeUtf8(word, position);
+        // the longer sequences accepted by the validation are not Unicode, the word is left as it is
+        if (codepoint > MAX_CODEPOINT) {
+            return false;
+        }
+        original.push_back(codepoint);
+        decompose(codepoint);
+    }
+    reorderMarks();
+    compose();
+    if (codepoints == original) {
+        return false;
+    }
+    for (const char32_t codepoint : codepoints) {
+        char sequence[4];
+        destination.append(sequence, string_utilities::encodeUtf8(codepoint, sequence));
+    }
+    return true;
+}
+
+void NfcNormalizer::decompose(char32_t codepoint)
+{
+    if (codepoint >= SYLLABLE_BASE && codepoint < SYLLABLE_BASE + SYLLABLE_COUNT) {
+        const char32_t index = codepoint - SYLLABLE_BASE;
+        codepoints.push_back(LEADING_BASE + index / SYLLABLES_PER_LEADER);
+        codepoints.push_back(VOWEL_BASE + index % SYLLABLES_PER_LEADER / TRAILING_COUNT);
+        if (index % TRAILING_COUNT != 0) {
+            codepoints.push_back(TRAILING_BASE + index % TRAILING_COUNT);
+        }
+        return;
+    }
+    const auto decomposition =
+        codepoint < FIRST_DECOMPOSABLE
+            ? canonicalDecompositions.end()
+            : ranges::lower_bound(canonicalDecompositions, codepoint, {}, &CanonicalDecomposition::codepoint);
+    if (decomposition == canonicalDecompositions.end() || decomposition->codepoint != codepoint) {
+        codepoints.push_back(codepoint);
+        return;
+    }
+    decompose(decomposition->first);
+    if (decomposition->second != 0) {
+        decompose(decomposition->second);
+    }
+}
+
+// the marks following a character are sorted by combining class, marks of the same class keep their order
+void NfcNormalizer::reorderMarks()
+{
+    for (size_t i = 1; i < codepoints.size(); ++i) {
+        const uint8_t markClass = combiningClass(codepoints[i]);
+        if (markClass == 0) {
+            continue;
+        }
+        for (size_t j = i; j > 0 && combiningClass(codepoints[j - 1]) > markClass; --j) {
+            swap(codepoints[j - 1], codepoints[j]);
+        }
+    }
+}
+
+// each character is composed with the last starter, unless a character of the same or a higher class
+// stands between them
+void NfcNormalizer::compose()
+{
+    if (codepoints.empty()) {
+        return;
+    }
+    size_t starter = 0;
+    // 256 blocks any composition until the first starter
+    int lastClass  = combiningClass(codepoints[0]) == 0 ? 0 : 256;
+    size_t written = 1;
+    for (size_t i = 1; i < codepoints.size(); ++i) {
+        const char32_t codepoint = codepoints[i];
+        const int markClass      = combiningClass(codepoint);
+        const char32_t composite = composePair(codepoints[starter], codepoint);
+        if (composite != 0 && (lastClass < markClass || lastClass == 0)) {
+            codepoints[starter] = composite;
+            continue;
+        }
+        if (markClass == 0) {
+            starter = written;
+        }
+        lastClass             = markClass;
+        codepoints[written++] = codepoint;
+    }
+    codepoints.resize(written);
+}
@@ -0,0 +1,70 @@
+#include "NumaTopology.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    string readLine(const string& path)
+    {
+        ifstream file(path);
+        string line;
+        getline(file, line);
+        return line;
+    }
+} // namespace
+
+vector<vector<unsigned>> numa::nodeCores(const string& root)
+{
+    vector<vector<unsigned>> cores;
+    for (const unsigned node : parseList(readLine(root + "/online"))) {
+        // a node of memory only has no core to run a worker
+        if (vector<unsigned> nodeCores = parseList(readLine(root + "/node" + to_string(node) + "/cpulist"));
+            !nodeCores.empty()) {
+            cores.push_back(std::move(nodeCores));
+        }
+    }
+    if (cores.empty()) {
+        cores.emplace_back(max(thread::hardware_concurrency(), 1U));
+        for (unsigned core = 0; core < cores[0].size(); ++core) {
+            cores[0][core] = core;
+        }
+    }
+    return cores;
+}
+
+// a malformed list gives the values read up to the error
+vector<unsigned> numa::parseList(string_view list)
+{
+    vector<unsigned> values;
+    const char* position = list.data();
+    const char* end      = list.data() + list.size();
+    while (position != end) {
+        unsigned first               = 0;
+        const from_chars_result read = from_chars(position, end, first);
+        if (read.ec != errc()) {
+            break;
+        }
+        const char* next = read.ptr;
+        unsigned last    = first;
+        if (next != end && *next == '-') {
+            const from_chars_result readLast = from_chars(next + 1, end, last);
+            if (readLast.ec != errc() || last < first) {
+                break;
+            }
+            next = readLast.ptr;
+        }
+        for (unsigned value = first; value <= last; ++value) {
+            values.push_back(value);
+        }
+        if (next == end || *next != ',') {
+            break;
+        }
+        position = next + 1;
+    }
+    return values;
+}
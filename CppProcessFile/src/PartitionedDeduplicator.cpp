@@ -0,0 +1,153 @@
+#include "PartitionedDeduplicator.h"
+#include "WordSet.h"
+#include "WorkStealingScheduler.h"
+
+#include <functional>
+#include <memory_resource>
+#include <queue>
+#include <span>
+#include <utility>
+
+using namespace std;
+
+PartitionedDeduplicator::PartitionedDeduplicator(size_t schemeCount, bool usesHugePages) :
+    schemeCount(schemeCount), usesHugePages(usesHugePages)
+{
+}
+
+size_t PartitionedDeduplicator::partitionOf(uint64_t hash)
+{
+    return (hash >> (57 - PARTITION_BITS)) & (PARTITION_COUNT - 1);
+}
+
+// a word repeated within the chunk is left out here already, so the slices hold much less than the chunk
+void PartitionedDeduplicator::split(const Chunk& chunk, vector<PartitionSlice>& slices) const
+{
+    pmr::memory_resource* const upstream = chunk.memory->upstream();
+    slices.clear();
+    for (size_t i = 0; i < PARTITION_COUNT; ++i) {
+        slices.push_back(
+            { pmr::string(upstream), pmr::vector<PartitionSlice::Word>(upstream), pmr::vector<int>(upstream) });
+    }
+    WordSet chunkWords;
+    chunkWords.reserve(chunk.words.size());
+    for (size_t i = 0; i < chunk.words.size(); ++i) {
+        const string_view word = chunk.words[i];
+        const string_view key  = chunk.keys.empty() ? word : chunk.keys[i];
+        if (!chunkWords.insert(key, chunk.hashes[i]).second) {
+            continue;
+        }
+        PartitionSlice& slice = slices[partitionOf(chunk.hashes[i])];
+        const bool hasKey     = key != word;
+        slice.words.push_back({ static_cast<uint32_t>(i),
+            static_cast<uint32_t>(word.size()),
+            static_cast<uint32_t>(hasKey ? key.size() : 0),
+            chunk.hashes[i] });
+        slice.bytes.append(word);
+        if (hasKey) {
+            slice.bytes.append(key);
+        }
+        const auto points = span(chunk.points).subspan(i * schemeCount, schemeCount);
+        slice.points.insert(slice.points.end(), points.begin(), points.end());
+    }
+}
+
+void PartitionedDeduplicator::append(vector<PartitionSlice>&& chunkSlices)
+{
+    slices.push_back(std::move(chunkSlices));
+}
+
+void PartitionedDeduplicator::finish(WorkStealingScheduler& scheduler, UniqueWords& uniqueWords)
+{
+    // the hash spreads the words evenly, a partition holds a share of the estimate, give or take a few percent
+    const size_t share    = uniqueWords.sketch.upperBound() / PARTITION_COUNT;
+    const size_t capacity = share + share / 8;
+    vector<Partition> partitions(PARTITION_COUNT);
+    TaskGroup partitionTasks(scheduler);
+    for (size_t i = 0; i < PARTITION_COUNT; ++i) {
+        const auto node = static_cast<unsigned>(i * scheduler.nodeCount() / PARTITION_COUNT);
+        partitionTasks.run([this, &partitions, i, capacity]() { deduplicate(i, capacity, partitions[i]); }, node);
+    }
+    partitionTasks.wait();
+    slices.clear();
+    merge(partitions, uniqueWords);
+}
+
+// the chunks are walked in input order, so the first occurrence of a word is the first one met
+void PartitionedDeduplicator::deduplicate(size_t partitionIndex, size_t capacity, Partition& partition)
+{
+    WordSet partitionWords(usesHugePages);
+    partitionWords.reserve(capacity);
+    partition.arena = WordArena(usesHugePages);
+    partition.positions.reserve(capacity);
+    partition.words.reserve(capacity);
+    partition.points.reserve(capacity * schemeCount);
+    vector<string_view> words;
+    vector<string_view> keys;
+    vector<uint64_t> hashes;
+    for (size_t chunk = 0; chunk < slices.size(); ++chunk) {
+        PartitionSlice& slice = slices[chunk][partitionIndex];
+        words.clear();
+        keys.clear();
+        hashes.clear();
+        size_t offset = 0;
+        for (const PartitionSlice::Word& entry : slice.words) {
+            const string_view rest = string_view(slice.bytes).substr(offset);
+            words.push_back(rest.substr(0, entry.length));
+            keys.push_back(entry.keyLength == 0 ? words.back() : rest.substr(entry.length, entry.keyLength));
+            hashes.push_back(entry.hash);
+            offset += entry.length + entry.keyLength;
+        }
+        partitionWords.insertBatch(keys, hashes, [&](size_t i, string_view& storedKey) {
+            // the slices are released as soon as they are read, the set keeps copies owned by the arena
+            const ArenaWord word = partition.arena.store(words[i]);
+            partition.words.push_back(word);
+            storedKey = partition.arena.view(keys[i] == words[i] ? word : partition.arena.store(keys[i]));
+            partition.positions.push_back((static_cast<uint64_t>(chunk) << 32) | slice.words[i].index);
+            const auto points = span(slice.points).subspan(i * schemeCount, schemeCount);
+            partition.points.insert(partition.points.end(), points.begin(), points.end());
+        });
+        chunk_memory::freeContainer(slice.bytes);
+        chunk_memory::freeContainer(slice.words);
+        chunk_memory::freeContainer(slice.points);
+    }
+}
+
+// the partitions are each in order of first occurrence, a heap of their next positions merges them
+// the arenas of the partitions are adopted first, the words are moved to their place in the arena of uniqueWords
+void PartitionedDeduplicator::merge(vector<Partition>& partitions, UniqueWords& uniqueWords) const
+{
+    using Head = pair<uint64_t, size_t>;
+    priority_queue<Head, vector<Head>, greater<Head>> heads;
+    vector<size_t> nextWords(partitions.size(), 0);
+    vector<uint64_t> shifts;
+    size_t uniqueCount = uniqueWords.words.size();
+    for (Partition& partition : partitions) {
+        shifts.push_back(uniqueWords.arena.adopt(std::move(partition.arena)));
+        uniqueCount += partition.words.size();
+    }
+    uniqueWords.words.reserve(uniqueCount);
+    for (pmr::vector<int>& points : uniqueWords.pointsPerScheme) {
+        points.reserve(uniqueCount);
+    }
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        if (!partitions[i].positions.empty()) {
+            heads.emplace(partitions[i].positions[0], i);
+        }
+    }
+    while (!heads.empty()) {
+        const size_t i = heads.top().second;
+        heads.pop();
+        const Partition& partition = partitions[i];
+        const size_t word          = nextWords[i]++;
+        ArenaWord movedWord        = partition.words[word];
+        movedWord.position += shifts[i];
+        uniqueWords.words.push_back(movedWord);
+        for (size_t scheme = 0; scheme < schemeCount; ++scheme) {
+            uniqueWords.pointsPerScheme[scheme].push_back(partition.points[word * schemeCount + scheme]);
+        }
+        if (nextWords[i] < partition.positions.size()) {
+            heads.emplace(partition.positions[nextWords[i]], i);
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#include "ProcessingPipeline.h"
+#include "ChunkReader.h"
+
+#include <algorithm>
+#include <span>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+ProcessingPipeline::ProcessingPipeline(
+    const ProcessingOptions& options, WorkStealingScheduler& scheduler, pmr::memory_resource* memory) :
+    options(options),
+    scheduler(scheduler),
+    tokenizeTasks(scheduler),
+    tokenizedChunks(max<size_t>(options.chunkCount, 2)),
+    freeChunks(max<size_t>(options.chunkCount, 2))
+{
+    // a chunk owns its memory, which is not copied, so the chunks are made one by one
+    const size_t chunkCount = max<size_t>(options.chunkCount, 2);
+    chunks.reserve(chunkCount);
+    for (size_t i = 0; i < chunkCount; ++i) {
+        chunks.emplace_back(options.useHugePages, memory);
+    }
+}
+
+Expected<void> ProcessingPipeline::run(
+    ByteSource& input, const ChunkStage& tokenizeStage, const ChunkStage& consumeStage)
+{
+    if (scheduler.nodeCount() > 1) {
+        touchBuffers();
+    }
+    for (uint32_t index = 0; index < chunks.size(); ++index) {
+        freeChunks.push(index);
+    }
+    {
+        // the reader blocks on I/O, so it gets its own thread instead of a worker
+        jthread reader([this, &input, &tokenizeStage]() { readChunks(input, tokenizeStage); });
+        consumeChunks(consumeStage);
+    }
+    // the tasks reference the pipeline
+    tokenizeTasks.wait();
+
+    if (firstError) {
+        return *firstError;
+    }
+    return {};
+}
+
+void ProcessingPipeline::abort(Error error)
+{
+    {
+        lock_guard lock(errorMutex);
+        if (!firstError) {
+            firstError = std::move(error);
+        }
+    }
+    aborted = true;
+    tokenizedChunks.close();
+    freeChunks.close();
+}
+
+unsigned ProcessingPipeline::nodeOf(uint32_t index) const
+{
+    return index % scheduler.nodeCount();
+}
+
+// the buffers are sized for a chunk and a carry as long, so that the reader does not reallocate them on its own node
+void ProcessingPipeline::touchBuffers()
+{
+    TaskGroup touchTasks(scheduler);
+    for (uint32_t index = 0; index < chunks.size(); ++index) {
+        touchTasks.run(
+            [this, index]() {
+                HugePageVector<char>& buffer = chunks[index].buffer;
+                buffer.resize(max(buffer.size(), 2 * options.chunkSize));
+            },
+            nodeOf(index));
+    }
+    touchTasks.wait();
+}
+
+void ProcessingPipeline::readChunks(ByteSource& input, const ChunkStage& tokenizeStage)
+{
+    ChunkReader chunkReader(options.chunkSize, options.invalidInputPolicy == InvalidInputPolicy::SkipLine);
+    uint32_t index = 0;
+    while (!chunkReader.isEndOfInput() && !aborted && freeChunks.pop(index)) {
+        Chunk& chunk = chunks[index];
+        chunkReader.begin(chunk);
+        Expected<size_t> readCount = size_t { 0 };
+        do {
+            const span<char> destination = chunkReader.nextRead(chunk);
+            readCount                    = input.read(destination.data(), destination.size());
+            if (!readCount) {
+                abort(readCount.error());
+                return;
+            }
+        } while (!chunkReader.commit(chunk, *readCount));
+        tokenizeTasks.run([this, index, &tokenizeStage]() { tokenizeChunk(index, tokenizeStage); }, nodeOf(index));
+    }
+    chunkTotal = chunkReader.chunkCount();
+    readerFinished.store(true, memory_order_release);
+}
+
+void ProcessingPipeline::tokenizeChunk(uint32_t index, const ChunkStage& tokenizeStage)
+{
+    if (aborted) {
+        return;
+    }
+    if (Expected<void> tokenized = tokenizeStage(chunks[index]); !tokenized) {
+        abort(tokenized.error());
+        return;
+    }
+    tokenizedChunks.push(index);
+}
+
+// the tokenizers finish out of order, a chunk waits in its slot until all the previous chunks are consumed
+// at most chunks.size() consecutive sequences are in flight, so the slot sequence % chunks.size() is free
+// while no chunk is ready, the consumer runs queued tasks, so that it never waits on a task nobody runs
+void ProcessingPipeline::consumeChunks(const ChunkStage& consumeStage)
+{
+    constexpr uint32_t NO_CHUNK = UINT32_MAX;
+    vector<uint32_t> waitingChunks(chunks.size(), NO_CHUNK);
+    size_t nextSequence = 0;
+    uint32_t index      = 0;
+    while (!aborted) {
+        // a backoff per wait, as RingBufferBase::pop does, so that it spins again before yielding
+        RingBufferBackoff backoff;
+        while (!tokenizedChunks.tryPop(index)) {
+            if (aborted || (readerFinished.load(memory_order_acquire) && nextSequence == chunkTotal)) {
+                return;
+            }
+            if (!scheduler.runPendingTask()) {
+                backoff.pause();
+            }
+        }
+        waitingChunks[chunks[index].sequence % chunks.size()] = index;
+        while (waitingChunks[nextSequence % chunks.size()] != NO_CHUNK) {
+            const uint32_t readyIndex = exchange(waitingChunks[nextSequence % chunks.size()], NO_CHUNK);
+            if (Expected<void> consumed = consumeStage(chunks[readyIndex]); !consumed) {
+                abort(consumed.error());
+                return;
+            }
+            freeChunks.push(readyIndex);
+            ++nextSequence;
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include "ScoringScheme.h"
+#include "StringUtilities.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+using namespace std;
+
+namespace
+{
+    Error invalidLineError(const string& path, size_t lineNumber)
+    {
+        return { ErrorCode::ScoringScheme,
+            "Error - Invalid line " + to_string(lineNumber) + " in the scoring scheme file " + path + "." };
+    }
+
+    // "é" or "U+00E9"
+    bool parseLetter(string_view field, char32_t& codepoint)
+    {
+        if (field.size() > 2 && (field.starts_with("U+") || field.starts_with("u+"))) {
+            uint32_t value    = 0;
+            const auto result = from_chars(field.data() + 2, field.data() + field.size(), value, 16);
+            codepoint         = value;
+            return result.ec == errc() && result.ptr == field.data() + field.size() && value <= 0x10FFFF;
+        }
+        if (field.empty() || string_utilities::find_first_not_utf8(field) < field.size()) {
+            return false;
+        }
+        size_t position = 0;
+        codepoint       = string_utilities::decodeUtf8(field, position);
+        return position == field.size();
+    }
+
+    bool parsePoints(string_view field, int& points)
+    {
+        const auto result = from_chars(field.data(), field.data() + field.size(), points);
+        return result.ec == errc() && result.ptr == field.data() + field.size();
+    }
+} // namespace
+
+ScoringScheme::ScoringScheme(string name, span<const Entry> entries) :
+    name(std::move(name)),
+    blockIndices((MAX_CODEPOINT >> BLOCK_BITS) + 1, 0),
+    blockPoints(BLOCK_MASK + 1, 0)
+{
+    for (const auto& [codepoint, points] : entries) {
+        if (codepoint > MAX_CODEPOINT) {
+            continue;
+        }
+        uint16_t& blockIndex = blockIndices[codepoint >> BLOCK_BITS];
+        if (blockIndex == 0) {
+            blockIndex = static_cast<uint16_t>(blockPoints.size() >> BLOCK_BITS);
+            blockPoints.resize(blockPoints.size() + BLOCK_MASK + 1, 0);
+        }
+        blockPoints[(static_cast<size_t>(blockIndex) << BLOCK_BITS) | (codepoint & BLOCK_MASK)] = points;
+    }
+}
+
+shared_ptr<const ScoringScheme> ScoringScheme::defaultScheme()
+{
+    static const auto scheme = make_shared<const ScoringScheme>("default", defaultAlphabet);
+    return scheme;
+}
+
+Expected<shared_ptr<const ScoringScheme>> ScoringScheme::loadFromFile(const string& path)
+{
+    ifstream schemeFile(path);
+    if (!schemeFile.is_open()) {
+        return Error { ErrorCode::FileOpen, "Error - Impossible to open the scoring scheme file " + path + "." };
+    }
+    vector<Entry> entries;
+    set<char32_t> letters;
+    string line;
+    for (size_t lineNumber = 1; getline(schemeFile, line); ++lineNumber) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        const size_t tab   = line.find('\t');
+        char32_t codepoint = 0;
+        int points         = 0;
+        if (tab == string::npos || !parseLetter(string_view(line).substr(0, tab), codepoint) ||
+            !parsePoints(string_view(line).substr(tab + 1), points) || !letters.insert(codepoint).second) {
+            return invalidLineError(path, lineNumber);
+        }
+        entries.push_back({ codepoint, points });
+    }
+    if (schemeFile.bad()) {
+        return Error { ErrorCode::FileRead, "Error - Impossible to read the scoring scheme file " + path + "." };
+    }
+    return make_shared<const ScoringScheme>(filesystem::path(path).stem().string(), entries);
+}
+
+const string& ScoringScheme::getName() const
+{
+    return name;
+}
+
+int ScoringScheme::countPoints(string_view word) const
+{
+    int total = 0;
+    for (size_t position = 0; position < word.size();) {
+        total += points(string_utilities::decodeUtf8(word, position));
+    }
+    return total;
+}
@@ -0,0 +1,228 @@
+#include "Tokenizer.h"
+#include "CaseFolding.h"
+#include "StringUtilities.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    constexpr size_t BLOCK_SIZE = 64;
+    // the match of the apostrophe reads two bytes past the block
+    constexpr size_t LOOKAHEAD = 2;
+
+    // one bit per byte of a block, bit i for the byte i
+    struct BlockMasks
+    {
+        // the whitespace of string_utilities::isWhitespace and the bytes of the apostrophes U+2019, which end words
+        uint64_t separators;
+        // ' and , which are removed from the words
+        uint64_t removed;
+        uint64_t lineFeeds;
+        // the bytes of the multi-byte characters, the apostrophe is only looked for in a block that has some
+        uint64_t highBits;
+        // the bytes of the next block that belong to an apostrophe starting at the end of this one
+        uint64_t carriedSeparators;
+    };
+
+    // the apostrophe U+2019 is E2 80 99 in UTF-8, the separators are its three bytes from each of its starts
+    void addApostrophes(uint64_t starts, BlockMasks& masks)
+    {
+        masks.separators |= starts | starts << 1 | starts << 2;
+        masks.carriedSeparators = starts >> (BLOCK_SIZE - 2) | starts >> (BLOCK_SIZE - 1);
+    }
+
+#if defined(__SSE2__) || defined(_M_X64)
+    uint64_t bitsOf(__m128i matches)
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(matches));
+    }
+
+    __m128i equal(__m128i bytes, char c)
+    {
+        return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c));
+    }
+
+    // reads BLOCK_SIZE + LOOKAHEAD bytes, 16 at a time
+    BlockMasks classify(const char* block)
+    {
+        BlockMasks masks {};
+        for (size_t lane = 0; lane < BLOCK_SIZE; lane += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + lane));
+            // \t \n \v \f \r, 09 to 0D, are moved to the bottom of the signed range and found with one comparison
+            const __m128i controls = _mm_cmplt_epi8(
+                _mm_sub_epi8(bytes, _mm_set1_epi8(static_cast<char>(0x89))), _mm_set1_epi8(static_cast<char>(0x85)));
+            masks.separators |= bitsOf(_mm_or_si128(controls, equal(bytes, ' '))) << lane;
+            masks.removed |= bitsOf(_mm_or_si128(equal(bytes, '\''), equal(bytes, ','))) << lane;
+            masks.lineFeeds |= bitsOf(equal(bytes, '\n')) << lane;
+            masks.highBits |= bitsOf(bytes) << lane;
+        }
+        if (masks.highBits == 0) {
+            return masks;
+        }
+        // the three bytes are compared at once, on three loads one byte apart
+        uint64_t starts = 0;
+        for (size_t lane = 0; lane < BLOCK_SIZE; lane += 16) {
+            const char* const bytes = block + lane;
+            const __m128i first     = equal(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)), '\xE2');
+            const __m128i second    = equal(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 1)), '\x80');
+            const __m128i third     = equal(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 2)), '\x99');
+            starts |= bitsOf(_mm_and_si128(first, _mm_and_si128(second, third))) << lane;
+        }
+        addApostrophes(starts, masks);
+        return masks;
+    }
+#else
+    BlockMasks classify(const char* block)
+    {
+        BlockMasks masks {};
+        uint64_t starts = 0;
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            const char c = block[i];
+            masks.separators |= static_cast<uint64_t>(string_utilities::isWhitespace(c)) << i;
+            masks.removed |= static_cast<uint64_t>(c == '\'' || c == ',') << i;
+            masks.lineFeeds |= static_cast<uint64_t>(c == '\n') << i;
+            masks.highBits |= static_cast<uint64_t>(static_cast<unsigned char>(c) >= 0x80) << i;
+            starts |= static_cast<uint64_t>(c == '\xE2' && block[i + 1] == '\x80' && block[i + 2] == '\x99') << i;
+        }
+        addApostrophes(starts, masks);
+        return masks;
+    }
+#endif
+
+    // moves a run down to destination, the separators and the removed bytes passed so far being squeezed out
+    // once the run is 16 bytes or more behind, it moves by whole copies of 16 bytes: the bytes written past its end
+    // are bytes already read, and the bytes read past its end are within the chunk
+    void moveDown(char* destination, const char* source, size_t length, const char* end)
+    {
+        constexpr size_t COPY_SIZE = 16;
+        if (source - destination < static_cast<ptrdiff_t>(COPY_SIZE)
+            || end - (source + length) < static_cast<ptrdiff_t>(COPY_SIZE)) {
+            memmove(destination, source, length);
+            return;
+        }
+        for (size_t offset = 0; offset < length; offset += COPY_SIZE) {
+            char bytes[COPY_SIZE];
+            memcpy(bytes, source + offset, COPY_SIZE);
+            memcpy(destination + offset, bytes, COPY_SIZE);
+        }
+    }
+
+    // the words are the runs of kept bytes between separators, the removed bytes inside a word are squeezed out
+    // the bytes are classified a block at a time, then the runs are taken from the masks with bit scans, so that the
+    // loop turns once per run rather than once per byte
+    // the recording is a template parameter, so that the loop without it is not slowed down by tests
+    template <bool RECORDS_POSITIONS>
+    void tokenizeChunk(Chunk& chunk)
+    {
+        // the first use of the chunk guesses a word every 6 bytes, as in English text
+        const size_t expectedWordCount = chunk.previousWordCount != 0
+            ? chunk.previousWordCount + chunk.previousWordCount / 8
+            : chunk.size / 6;
+        chunk.words.clear();
+        chunk.words.reserve(expectedWordCount);
+        if constexpr (RECORDS_POSITIONS) {
+            chunk.wordPositions.clear();
+            chunk.wordPositions.reserve(expectedWordCount);
+            chunk.lineEnds.clear();
+        }
+        char* const begin     = chunk.buffer.data();
+        const char* const end = begin + chunk.size;
+        // removing characters only shrinks the words, so they can be rewritten in place, behind the bytes classified
+        char* write           = begin;
+        char* wordStart       = write;
+        const char* wordBegin = begin;
+        const auto finishWord = [&chunk, &write, &wordStart, &wordBegin, begin](const char* separator) {
+            if (write != wordStart) {
+                chunk.words.emplace_back(wordStart, static_cast<size_t>(write - wordStart));
+                if constexpr (RECORDS_POSITIONS) {
+                    chunk.wordPositions.push_back(
+                        { static_cast<uint32_t>(wordBegin - begin), static_cast<uint32_t>(separator - wordBegin) });
+                }
+            }
+            wordStart = write;
+        };
+        uint64_t carriedSeparators = 0;
+        for (char* block = begin; block < end; block += BLOCK_SIZE) {
+            const auto available = static_cast<size_t>(end - block);
+            BlockMasks masks;
+            if (available >= BLOCK_SIZE + LOOKAHEAD) {
+                masks = classify(block);
+            } else {
+                // the end of the chunk is classified from a copy, the zeros after it match nothing
+                char padded[BLOCK_SIZE + LOOKAHEAD] = {};
+                memcpy(padded, block, available);
+                masks = classify(padded);
+            }
+            const uint64_t valid = available >= BLOCK_SIZE ? ~uint64_t { 0 } : (uint64_t { 1 } << available) - 1;
+            uint64_t separators  = (masks.separators | carriedSeparators) & valid;
+            uint64_t kept        = ~(separators | masks.removed) & valid;
+            carriedSeparators    = masks.carriedSeparators;
+            if constexpr (RECORDS_POSITIONS) {
+                for (uint64_t lineFeeds = masks.lineFeeds & valid; lineFeeds != 0; lineFeeds &= lineFeeds - 1) {
+                    chunk.lineEnds.push_back(static_cast<uint32_t>(block - begin + countr_zero(lineFeeds)));
+                }
+            }
+            while (kept != 0) {
+                const int start  = countr_zero(kept);
+                const int length = countr_one(kept >> start);
+                // a separator between the previous run and this one ends the word
+                if ((separators & ((uint64_t { 1 } << start) - 1)) != 0) {
+                    finishWord(block + countr_zero(separators));
+                }
+                separators &= ~uint64_t { 0 } << start;
+                char* const run = block + start;
+                if constexpr (RECORDS_POSITIONS) {
+                    if (write == wordStart) {
+                        wordBegin = run;
+                    }
+                }
+                // the first word is where it was, the others move down by the separators before them at least
+                if (write != run) {
+                    moveDown(write, run, static_cast<size_t>(length), end);
+                }
+                write += length;
+                // adding the lowest bit carries through the run and clears it
+                kept &= kept + (kept & (~kept + 1));
+            }
+            if (separators != 0) {
+                finishWord(block + countr_zero(separators));
+            }
+        }
+        finishWord(end);
+    }
+} // namespace
+
+Tokenizer::Tokenizer(bool recordsPositions, bool lowercases) :
+    recordsPositions(recordsPositions),
+    lowercases(lowercases)
+{
+}
+
+void Tokenizer::tokenize(Chunk& chunk) const
+{
+    if (recordsPositions) {
+        tokenizeChunk<true>(chunk);
+    } else {
+        tokenizeChunk<false>(chunk);
+    }
+    // the compaction leaves the words one after the other from the start of the buffer, they are lowered in one run
+    if (lowercases && !chunk.words.empty()) {
+        const string_view lastWord = chunk.words.back();
+        case_folding::toLowercase(span(chunk.buffer.data(), lastWord.data() + lastWord.size()));
+    }
+    // hashed here, in the parallel stage, the ordered deduplication only reads the words to compare them
+    chunk.hashes.resize(chunk.words.size());
+    for (size_t i = 0; i < chunk.words.size(); ++i) {
+        chunk.hashes[i] = string_utilities::hashWord(chunk.words[i]);
+    }
+}
@@ -0,0 +1,69 @@
+#include "WordArena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+using namespace std;
+
+WordArena::WordArena(bool usesHugePages) : usesHugePages(usesHugePages)
+{
+}
+
+ArenaWord WordArena::store(string_view word)
+{
+    uint64_t position = 0;
+    char* destination = nullptr;
+    if (word.size() > BLOCK_SIZE / 4) {
+        // a big word gets its own block, the free space of the current block is kept
+        position = static_cast<uint64_t>(blocks.size()) << BLOCK_BITS;
+        buffers.emplace_back(word.size(), usesHugePages);
+        blocks.push_back({ buffers.back().data(), word.size() });
+        destination = blocks.back().bytes;
+    } else {
+        if (freeCapacity < word.size()) {
+            addBlock();
+        }
+        position    = (static_cast<uint64_t>(freeBlock) << BLOCK_BITS) | (BLOCK_SIZE - freeCapacity);
+        destination = freeSpace;
+        freeSpace += word.size();
+        freeCapacity -= word.size();
+    }
+    memcpy(destination, word.data(), word.size());
+    return { position, min(word.size(), MAX_LENGTH) };
+}
+
+// a small arena does not take a whole huge page, its first blocks are allocated one at a time
+void WordArena::addBlock()
+{
+    if (freeBlockCount == 0) {
+        const bool isBig        = usesHugePages && blocks.size() * BLOCK_SIZE >= huge_pages::MIN_SIZE;
+        const size_t bufferSize = isBig ? huge_pages::HUGE_PAGE_SIZE : BLOCK_SIZE;
+        buffers.emplace_back(bufferSize, usesHugePages);
+        freeBlocks     = buffers.back().data();
+        freeBlockCount = bufferSize / BLOCK_SIZE;
+    }
+    freeBlock = blocks.size();
+    blocks.push_back({ freeBlocks, BLOCK_SIZE });
+    freeBlocks += BLOCK_SIZE;
+    --freeBlockCount;
+    freeSpace    = blocks.back().bytes;
+    freeCapacity = BLOCK_SIZE;
+}
+
+// the free space of the other arena is given up, the words are stored in the current block
+// the blocks of the other arena come after the blocks of this one, their words move by as many blocks
+uint64_t WordArena::adopt(WordArena&& other)
+{
+    const uint64_t shift = static_cast<uint64_t>(blocks.size()) << BLOCK_BITS;
+    buffers.insert(buffers.end(), make_move_iterator(other.buffers.begin()), make_move_iterator(other.buffers.end()));
+    blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+    other.buffers.clear();
+    other.blocks.clear();
+    other.freeBlocks     = nullptr;
+    other.freeBlockCount = 0;
+    other.freeBlock      = 0;
+    other.freeSpace      = nullptr;
+    other.freeCapacity   = 0;
+    return shift;
+}
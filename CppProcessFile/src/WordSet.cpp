@@ -0,0 +1,59 @@
+#include "WordSet.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+using namespace std;
+
+WordSet::WordSet(bool usesHugePages) :
+    controls(HugePageAllocator<uint8_t>(usesHugePages)), slots(HugePageAllocator<Slot>(usesHugePages))
+{
+}
+
+size_t WordSet::size() const
+{
+    return wordCount;
+}
+
+void WordSet::reserve(size_t count)
+{
+    size_t groupCount = max(slots.size() / GROUP_SIZE, size_t { 1 });
+    while (groupCount * GROUP_SIZE / 8 * 7 < count) {
+        groupCount *= 2;
+    }
+    if (groupCount * GROUP_SIZE > slots.size()) {
+        rehash(groupCount);
+    }
+}
+
+void WordSet::grow()
+{
+    rehash(max(slots.size() / GROUP_SIZE * 2, size_t { 1 }));
+}
+
+// the slots are placed again from their cached hashes, the words are not read
+// the new arrays are allocated as the old ones were
+void WordSet::rehash(size_t groupCount)
+{
+    const size_t slotCount = groupCount * GROUP_SIZE;
+    HugePageVector<uint8_t> oldControls =
+        exchange(controls, HugePageVector<uint8_t>(slotCount, EMPTY, controls.get_allocator()));
+    HugePageVector<Slot> oldSlots = exchange(slots, HugePageVector<Slot>(slotCount, Slot {}, slots.get_allocator()));
+    groupMask                     = groupCount - 1;
+    maxWordCount                  = slotCount / 8 * 7;
+    for (size_t i = 0; i < oldSlots.size(); ++i) {
+        if (oldControls[i] == EMPTY) {
+            continue;
+        }
+        size_t group = oldSlots[i].hash & groupMask;
+        for (size_t step = 1;; group = (group + step++) & groupMask) {
+            if (const uint32_t empties = match(controls.data() + group * GROUP_SIZE, EMPTY); empties != 0) {
+                const size_t index = group * GROUP_SIZE + countr_zero(empties);
+                controls[index]    = oldControls[i];
+                slots[index]       = oldSlots[i];
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,260 @@
+#include "WorkStealingScheduler.h"
+#include "NumaTopology.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // lets submit and runPendingTask know whether the calling thread is one of the workers
+    thread_local const WorkStealingScheduler* currentScheduler = nullptr;
+    thread_local unsigned currentWorkerIndex                   = 0;
+} // namespace
+
+// the workers of a node have consecutive indices
+WorkStealingScheduler::WorkStealingScheduler(unsigned workerCount, bool pinWorkers, bool spreadOverNodes)
+{
+    if (workerCount == 0) {
+        workerCount = max(thread::hardware_concurrency(), 1U);
+    }
+    const vector<vector<unsigned>> nodeCores = spreadOverNodes ? numa::nodeCores() : vector<vector<unsigned>>(1);
+    nodeWorkers.resize(min<size_t>(nodeCores.size(), workerCount));
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.push_back(make_unique<Worker>());
+        workerNodes.push_back(static_cast<unsigned>(size_t { i } * nodeWorkers.size() / workerCount));
+        nodeWorkers[workerNodes[i]].push_back(i);
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        vector<unsigned> cores;
+        if (nodeWorkers.size() > 1) {
+            // the cores of the node, or one of them
+            cores = nodeCores[workerNodes[i]];
+            if (pinWorkers) {
+                cores = { cores[(i - nodeWorkers[workerNodes[i]].front()) % cores.size()] };
+            }
+        } else if (pinWorkers) {
+            cores = { i };
+        }
+        threads.emplace_back([this, i, cores = std::move(cores)]() {
+            if (!cores.empty()) {
+                pinCurrentThread(cores);
+            }
+            runWorker(i);
+        });
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    {
+        lock_guard lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    threads.clear();
+}
+
+unsigned WorkStealingScheduler::workerCount() const
+{
+    return static_cast<unsigned>(workers.size());
+}
+
+unsigned WorkStealingScheduler::nodeCount() const
+{
+    return static_cast<unsigned>(nodeWorkers.size());
+}
+
+bool WorkStealingScheduler::isWorkerThread() const
+{
+    return currentScheduler == this;
+}
+
+void WorkStealingScheduler::submit(Task task, unsigned node)
+{
+    unsigned workerIndex = 0;
+    if (node == ANY_NODE || nodeCount() == 1) {
+        workerIndex =
+            isWorkerThread() ? currentWorkerIndex : nextWorker.fetch_add(1, memory_order_relaxed) % workerCount();
+    } else if (isWorkerThread() && workerNodes[currentWorkerIndex] == node % nodeCount()) {
+        workerIndex = currentWorkerIndex;
+    } else {
+        // the workers of the node take turns
+        const vector<unsigned>& candidates = nodeWorkers[node % nodeCount()];
+        const size_t turn                  = nextWorker.fetch_add(1, memory_order_relaxed);
+        workerIndex                        = candidates[turn % candidates.size()];
+    }
+    {
+        lock_guard lock(workers[workerIndex]->mutex);
+        workers[workerIndex]->tasks.push_back(std::move(task));
+    }
+    // taking the lock orders the increment with the check of a worker going to sleep
+    lock_guard lock(sleepMutex);
+    ++queuedTasks;
+    wakeUp.notify_one();
+}
+
+bool WorkStealingScheduler::runPendingTask()
+{
+    Task task;
+    const unsigned firstVictim =
+        isWorkerThread() ? currentWorkerIndex : nextWorker.fetch_add(1, memory_order_relaxed) % workerCount();
+    if (!tryTakeTask(firstVictim, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void WorkStealingScheduler::runWorker(unsigned workerIndex)
+{
+    currentScheduler   = this;
+    currentWorkerIndex = workerIndex;
+    Task task;
+    while (true) {
+        if (tryTakeTask(workerIndex, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        unique_lock lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingScheduler::tryTakeTask(unsigned firstVictim, Task& task)
+{
+    if (queuedTasks.load(memory_order_acquire) == 0) {
+        return false;
+    }
+    if (isWorkerThread() && tryPopNewest(currentWorkerIndex, task)) {
+        return true;
+    }
+    // the workers of the same node are robbed first, the memory of their tasks is on this node
+    const unsigned node = workerNodes[isWorkerThread() ? currentWorkerIndex : firstVictim];
+    for (const bool isSameNode : { true, false }) {
+        for (unsigned i = 0; i < workerCount(); ++i) {
+            const unsigned victim = (firstVictim + i) % workerCount();
+            if ((workerNodes[victim] == node) == isSameNode && tryStealOldest(victim, task)) {
+                return true;
+            }
+        }
+        if (nodeCount() == 1) {
+            break;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingScheduler::tryPopNewest(unsigned workerIndex, Task& task)
+{
+    Worker& worker = *workers[workerIndex];
+    lock_guard lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    --queuedTasks;
+    return true;
+}
+
+bool WorkStealingScheduler::tryStealOldest(unsigned workerIndex, Task& task)
+{
+    Worker& worker = *workers[workerIndex];
+    lock_guard lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    --queuedTasks;
+    return true;
+}
+
+void WorkStealingScheduler::pinCurrentThread(const vector<unsigned>& cores)
+{
+#ifdef __linux__
+    cpu_set_t coreSet;
+    CPU_ZERO(&coreSet);
+    for (const unsigned core : cores) {
+        CPU_SET(core % max(thread::hardware_concurrency(), 1U), &coreSet);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(coreSet), &coreSet);
+#else
+    static_cast<void>(cores);
+#endif
+}
+
+TaskGroup::TaskGroup(WorkStealingScheduler& scheduler) : scheduler(scheduler)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    // the tasks reference the group, they must be done before it goes away
+#if defined(__cpp_exceptions)
+    try {
+        wait();
+    } catch (...) {
+        // the error was not waited for, it is dropped
+    }
+#else
+    wait();
+#endif
+}
+
+void TaskGroup::run(WorkStealingScheduler::Task task, unsigned node)
+{
+    ++pendingTasks;
+    scheduler.submit(
+        [this, task = std::move(task)]() {
+            exception_ptr error;
+#if defined(__cpp_exceptions)
+            try {
+                task();
+            } catch (...) {
+                error = current_exception();
+            }
+#else
+            task();
+#endif
+            // wait takes the mutex before returning, so the group outlives this block
+            lock_guard lock(mutex);
+            if (error && !firstError) {
+                firstError = error;
+            }
+            if (--pendingTasks == 0) {
+                pendingTasks.notify_all();
+            }
+        },
+        node);
+}
+
+void TaskGroup::wait()
+{
+    // a worker keeps running tasks while it waits, another thread sleeps
+    for (size_t pending = pendingTasks.load(); pending != 0; pending = pendingTasks.load()) {
+        if (scheduler.isWorkerThread()) {
+            if (!scheduler.runPendingTask()) {
+                this_thread::yield();
+            }
+        } else {
+            pendingTasks.wait(pending);
+        }
+    }
+    lock_guard lock(mutex);
+    if (firstError) {
+        rethrow_exception(exchange(firstError, nullptr));
+    }
+}
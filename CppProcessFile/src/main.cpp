@@ -1,50 +1,239 @@
-
-#include "main.h"
-#include "CustomExceptions.h"
-#include "FileProcessor.h"
-
-#include <fstream>
-#include <iostream>
-#include <regex>
-#include <string>
-
-using namespace std;
-
-int main(int argc, char* argv[])
-{
-    try {
-        string inputPath = getFilePathFromArgv(argc, argv);
-        regex reg("(.txt)$");
-        string outputPath = std::regex_replace(inputPath, reg, ".count.txt");
-        cout << "Processing the file" << endl << inputPath << endl;
-        FileProcessor fileProcessor;
-        fileProcessor.process(inputPath, outputPath);
-        cout << "Processing success. The output lies in the file" << endl << outputPath << endl;
-    } catch (CustomException& ex) {
-        cerr << "Error with custom exception" << endl;
-        cerr << ex.what() << endl;
-        return 1;
-    } catch (exception& ex) {
-        cerr << "Error with unknown exception" << endl;
-        cerr << ex.what() << endl;
-        return 1;
-    }
-}
-
-std::string getFilePathFromArgv(int argc, char* argv[])
-{
-    if (argc != 2) {
-        throw ProgramArgumentsException("Error - Only 1 command line argument is expected.");
-    }
-    const auto filePath = std::string(argv[1]);
-    if (filePath.length() < 10) {
-        throw ProgramArgumentsException("Error - The path is too small, the full path is expected.");
-    }
-    fstream file;
-    file.open(filePath, ios::in);
-    if (!file.is_open()) {
-        throw ProgramArgumentsException("Error - The file in the program argument could not be opened");
-    }
-    file.close();
-    return filePath;
-}
+
+#include "main.h"
+#include "CustomExceptions.h"
+#include "FileProcessor.h"
+#include "ScoringScheme.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // the engine returns its errors, the command line reports them as exceptions
+    [[noreturn]] void throwError(const Error& error)
+    {
+        switch (error.code) {
+        case ErrorCode::FileOpen:
+            throw FileOpenException(error.message.c_str());
+        case ErrorCode::FileRead:
+            throw FileReadException(error.message.c_str());
+        case ErrorCode::NonUtf8Characters:
+            throw NonUtf8CharactersFoundException(error.message.c_str());
+        case ErrorCode::ScoringScheme:
+            throw ScoringSchemeException(error.message.c_str());
+        }
+        throw CustomException(error.message.c_str());
+    }
+
+    template <typename T>
+    T valueOrThrow(Expected<T> result)
+    {
+        if (!result) {
+            throwError(result.error());
+        }
+        if constexpr (!is_void_v<T>) {
+            return std::move(*result);
+        }
+    }
+
+    // a count too large for an unsigned is refused as any other value that is not a number
+    unsigned parseCount(const string& name, const string& value)
+    {
+        unsigned count = 0;
+        if (value.empty() || !ranges::all_of(value, [](char c) { return c >= '0' && c <= '9'; })
+            || from_chars(value.data(), value.data() + value.size(), count).ec != errc()) {
+            throw ProgramArgumentsException(("Error - The option --" + name + " expects a number.").c_str());
+        }
+        return count;
+    }
+
+    bool parseSwitch(const string& name, const string& value)
+    {
+        if (value != "on" && value != "off") {
+            throw ProgramArgumentsException(("Error - The option --" + name + " expects on or off.").c_str());
+        }
+        return value == "on";
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try {
+        const vector<string> inputPaths = getFilePathsFromArgv(argc, argv);
+        const ProcessingOptions options = getProcessingOptionsFromArgv(argc, argv);
+        regex reg("(.txt)$");
+        vector<pair<string, string>> inputAndOutputPaths;
+        for (const string& inputPath : inputPaths) {
+            inputAndOutputPaths.emplace_back(inputPath, std::regex_replace(inputPath, reg, ".count.txt"));
+        }
+        FileProcessor fileProcessor(options);
+        valueOrThrow(fileProcessor.checkOutputPaths(inputAndOutputPaths));
+        for (const string& inputPath : inputPaths) {
+            cout << "Processing the file" << endl << inputPath << endl;
+        }
+        const vector<FileStats> stats = valueOrThrow(fileProcessor.processFiles(inputAndOutputPaths));
+        for (size_t i = 0; i < inputAndOutputPaths.size(); ++i) {
+            const string& outputPath = inputAndOutputPaths[i].second;
+            for (const string& outputPathForScheme : fileProcessor.getOutputPaths(outputPath)) {
+                cout << "Processing success. The output lies in the file" << endl << outputPathForScheme << endl;
+            }
+            if (options.invalidInputPolicy != InvalidInputPolicy::Abort) {
+                cout << "The invalid input is reported in the file" << endl
+                     << fileProcessor.getInvalidInputReportPath(outputPath) << endl;
+            }
+            if (options.printsStats) {
+                cout << "Words: " << stats[i].wordCount << ", unique words: " << stats[i].uniqueWordCount
+                     << ", estimated unique words: " << stats[i].estimatedUniqueWordCount << endl;
+            }
+        }
+    } catch (CustomException& ex) {
+        cerr << "Error with custom exception" << endl;
+        cerr << ex.what() << endl;
+        return 1;
+    } catch (exception& ex) {
+        cerr << "Error with unknown exception" << endl;
+        cerr << ex.what() << endl;
+        return 1;
+    }
+}
+
+vector<string> getFilePathsFromArgv(int argc, char* argv[])
+{
+    vector<string> filePaths;
+    for (int i = 1; i < argc; ++i) {
+        if (!string(argv[i]).starts_with("--")) {
+            filePaths.push_back(getFilePathFromArgument(argv[i]));
+        }
+    }
+    if (filePaths.empty()) {
+        throw ProgramArgumentsException("Error - The path of at least one input file is expected.");
+    }
+    return filePaths;
+}
+
+std::string getFilePathFromArgument(const std::string& filePath)
+{
+    if (filePath.length() < 10) {
+        throw ProgramArgumentsException("Error - The path is too small, the full path is expected.");
+    }
+    fstream file;
+    file.open(filePath, ios::in);
+    if (!file.is_open()) {
+        throw ProgramArgumentsException("Error - The file in the program argument could not be opened");
+    }
+    file.close();
+    return filePath;
+}
+
+ProcessingOptions getProcessingOptionsFromArgv(int argc, char* argv[])
+{
+    ProcessingOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const string argument      = argv[i];
+        const size_t equalPosition = argument.find('=');
+        if (!argument.starts_with("--")) {
+            continue;
+        }
+        if (equalPosition == string::npos) {
+            throw ProgramArgumentsException("Error - Options are expected as --name=value.");
+        }
+        applyOption(argument.substr(2, equalPosition - 2), argument.substr(equalPosition + 1), options);
+    }
+    return options;
+}
+
+void applyOption(const string& name, const string& value, ProcessingOptions& options)
+{
+    if (name == "threads") {
+        options.threadCount = parseCount(name, value);
+    } else if (name == "pin-workers") {
+        options.pinWorkers = parseSwitch(name, value);
+    } else if (name == "numa") {
+        options.spreadOverNodes = parseSwitch(name, value);
+    } else if (name == "huge-pages") {
+        options.useHugePages = parseSwitch(name, value);
+    } else if (name == "async") {
+        options.useAsync = parseSwitch(name, value);
+    } else if (name == "io-threads") {
+        options.ioThreadCount = parseCount(name, value);
+    } else if (name == "scores") {
+        shared_ptr<const ScoringScheme> scheme = valueOrThrow(ScoringScheme::loadFromFile(value));
+        // the names tell the outputs apart, so two schemes must not share one
+        if (ranges::any_of(options.scoringSchemes, [&scheme](const auto& other) {
+                return other->getName() == scheme->getName();
+            })) {
+            throw ProgramArgumentsException("Error - Two scoring schemes have the same name.");
+        }
+        options.scoringSchemes.push_back(std::move(scheme));
+    } else if (name == "encoding") {
+        const unordered_map<string, InputEncoding> encodings = { { "utf-8", InputEncoding::Utf8 },
+            { "latin-1", InputEncoding::Latin1 },
+            { "cp1252", InputEncoding::Cp1252 },
+            { "utf-16le", InputEncoding::Utf16Le },
+            { "utf-16be", InputEncoding::Utf16Be },
+            { "auto", InputEncoding::Auto } };
+        const auto encoding = encodings.find(value);
+        if (encoding == encodings.end()) {
+            throw ProgramArgumentsException(
+                "Error - The option --encoding expects utf-8, latin-1, cp1252, utf-16le, utf-16be or auto.");
+        }
+        options.inputEncoding = encoding->second;
+    } else if (name == "fold-case") {
+        const unordered_map<string, CaseFolding> foldings = { { "off", CaseFolding::Off },
+            { "on", CaseFolding::Lower },
+            { "keep-spelling", CaseFolding::KeepSpelling } };
+        const auto folding = foldings.find(value);
+        if (folding == foldings.end()) {
+            throw ProgramArgumentsException("Error - The option --fold-case expects off, on or keep-spelling.");
+        }
+        options.caseFolding = folding->second;
+    } else if (name == "dedup") {
+        const unordered_map<string, DeduplicationMode> modes = { { "ordered", DeduplicationMode::Ordered },
+            { "partitioned", DeduplicationMode::Partitioned } };
+        const auto mode = modes.find(value);
+        if (mode == modes.end()) {
+            throw ProgramArgumentsException("Error - The option --dedup expects ordered or partitioned.");
+        }
+        options.deduplicationMode = mode->second;
+    } else if (name == "presize") {
+        options.presizeTables = parseSwitch(name, value);
+    } else if (name == "stats") {
+        options.printsStats = parseSwitch(name, value);
+    } else if (name == "nfc") {
+        options.normalizeToNfc = parseSwitch(name, value);
+    } else if (name == "on-invalid") {
+        const unordered_map<string, InvalidInputPolicy> policies = { { "abort", InvalidInputPolicy::Abort },
+            { "skip-word", InvalidInputPolicy::SkipWord },
+            { "skip-line", InvalidInputPolicy::SkipLine },
+            { "replace", InvalidInputPolicy::Replace } };
+        const auto policy = policies.find(value);
+        if (policy == policies.end()) {
+            throw ProgramArgumentsException(
+                "Error - The option --on-invalid expects abort, skip-word, skip-line or replace.");
+        }
+        options.invalidInputPolicy = policy->second;
+    } else if (name == "io") {
+        const unordered_map<string, IoBackend> backends = { { "stream", IoBackend::Stream },
+            { "pread", IoBackend::Pread },
+            { "mmap", IoBackend::Mmap },
+            { "uring", IoBackend::Uring } };
+        const auto backend = backends.find(value);
+        if (backend == backends.end()) {
+            throw ProgramArgumentsException("Error - The option --io expects uring, pread, mmap or stream.");
+        }
+        options.ioBackend = backend->second;
+    } else {
+        throw ProgramArgumentsException("Error - Unknown option.");
+    }
+}
@@ -0,0 +1,111 @@
+"""Writes include/UnicodeData.h, the tables of the NFC normalization, from the Unicode database of Python.
+
+Run from the CppProcessFile directory: python3 tools/generate_unicode_data.py
+"""
+
+import unicodedata
+
+HANGUL_SYLLABLES = range(0xAC00, 0xAC00 + 11172)
+COLUMN_LIMIT = 120
+
+
+def canonical_decompositions():
+    for codepoint in range(0x110000):
+        decomposition = unicodedata.decomposition(chr(codepoint))
+        # the compatibility decompositions start with a <tag>, the Hangul syllables are decomposed by rule
+        if not decomposition or decomposition.startswith("<") or codepoint in HANGUL_SYLLABLES:
+            continue
+        parts = [int(part, 16) for part in decomposition.split()]
+        yield codepoint, parts[0], parts[1] if len(parts) == 2 else 0
+
+
+def combining_class_ranges():
+    ranges = []
+    for codepoint in range(0x110000):
+        combining_class = unicodedata.combining(chr(codepoint))
+        if combining_class == 0:
+            continue
+        if ranges and ranges[-1][1] == codepoint - 1 and ranges[-1][2] == combining_class:
+            ranges[-1][1] = codepoint
+        else:
+            ranges.append([codepoint, codepoint, combining_class])
+    return ranges
+
+
+def format_table(entries):
+    lines = []
+    for cell in ("{ " + ", ".join(entry) + " }" for entry in entries):
+        # the indentation and the comma ending the line must fit too
+        if lines and len(lines[-1]) + len(cell) + 7 <= COLUMN_LIMIT:
+            lines[-1] += ", " + cell
+        else:
+            lines.append(cell)
+    return ",\n".join("    " + line for line in lines)
+
+
+def hexadecimal(codepoint):
+    return "0x%04X" % codepoint
+
+
+def main():
+    decompositions = list(canonical_decompositions())
+    # a pair composes when its composite is left as it is by NFC, the composition exclusions are not
+    compositions = sorted(
+        (first, second, codepoint)
+        for codepoint, first, second in decompositions
+        if second != 0 and unicodedata.normalize("NFC", chr(codepoint)) == chr(codepoint)
+    )
+    ranges = combining_class_ranges()
+    with open("include/UnicodeData.h", "w", newline="\r\n") as header:
+        header.write(
+            f"""#pragma once
+
+#include <array>
+#include <cstdint>
+
+// generated by tools/generate_unicode_data.py from the Unicode {unicodedata.unidata_version} database, do not edit
+
+// the canonical decomposition of a character into one or two characters, second is 0 for a single one
+// the Hangul syllables are decomposed by rule and are not listed
+struct CanonicalDecomposition
+{{
+    char32_t codepoint;
+    char32_t first;
+    char32_t second;
+}};
+
+// the pairs that compose into a primary composite, sorted by first then second
+struct CanonicalComposition
+{{
+    char32_t first;
+    char32_t second;
+    char32_t composite;
+}};
+
+// the characters from first to last have the canonical combining class, the others have class 0
+struct CombiningClassRange
+{{
+    char32_t first;
+    char32_t last;
+    std::uint8_t combiningClass;
+}};
+
+// clang-format off
+inline constexpr std::array<CanonicalDecomposition, {len(decompositions)}> canonicalDecompositions = {{ {{
+{format_table([(hexadecimal(c), hexadecimal(f), hexadecimal(s)) for c, f, s in decompositions])}
+}} }};
+
+inline constexpr std::array<CanonicalComposition, {len(compositions)}> canonicalCompositions = {{ {{
+{format_table([(hexadecimal(f), hexadecimal(s), hexadecimal(c)) for f, s, c in compositions])}
+}} }};
+
+inline constexpr std::array<CombiningClassRange, {len(ranges)}> combiningClassRanges = {{ {{
+{format_table([(hexadecimal(f), hexadecimal(l), str(k)) for f, l, k in ranges])}
+}} }};
+// clang-format on
+"""
+        )
+
+
+if __name__ == "__main__":
+    main()